@@ -0,0 +1,278 @@
+#include "bigint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Times each operation over a sweep of operand sizes and prints the results
+// as JSON or CSV. With --baseline, compares them against an earlier run and
+// exits with status 1 if any operation got slower by more than the threshold.
+// --threads sets bigint::tuning.threads, so a multi-core machine can compare
+// the parallel multiplication against --threads 1.
+//
+//   bigint_bench [--format json|csv] [--output FILE] [--ops add,mul,...]
+//                [--min-bits N] [--max-bits N] [--baseline FILE]
+//                [--threshold FRACTION] [--threads N]
+
+namespace {
+    struct result {
+        std::string op;
+        size_t bits;
+        size_t iterations;
+        double ns_min;
+        double ns_median;
+    };
+
+    // Keeps the compiler from discarding a result that is never read.
+    template<typename T> void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    std::mt19937_64 rng(0x62696769);
+
+    // A random number of exactly the given bit length.
+    bigint random_bits(size_t bits) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex((bits + 3) / 4, '0');
+        for (char& c : hex) c = digits[rng() & 0xf];
+        const size_t top = bits % 4 ? bits % 4 : 4;
+        hex[0] = digits[(1 << (top - 1)) | (rng() & ((1 << (top - 1)) - 1))];
+        return stobi(hex, nullptr, 16);
+    }
+
+    // The n for which n! has about the given number of bits.
+    unsigned long long factorial_arg(size_t bits) {
+        auto log2_factorial = [](double n) {return std::lgamma(n + 1) / std::log(2.0);};
+        unsigned long long lo = 1, hi = 2;
+        while (log2_factorial(static_cast<double>(hi)) < bits) hi *= 2;
+        while (lo + 1 < hi) {
+            const unsigned long long mid = lo + (hi - lo) / 2;
+            if (log2_factorial(static_cast<double>(mid)) < bits) lo = mid;
+            else hi = mid;
+        }
+        return hi;
+    }
+
+    // Each operation builds its operands for a size once and returns the body
+    // to time.
+    using body = std::function<void()>;
+    using setup = std::function<body(size_t)>;
+
+    const std::vector<std::pair<std::string, setup>>& operations() {
+        static const std::vector<std::pair<std::string, setup>> ops = {
+            {"add", [](size_t bits) -> body {
+                bigint a = random_bits(bits), b = random_bits(bits), r;
+                return [=]() mutable {r = a + b; keep(r);};
+            }},
+            {"sub", [](size_t bits) -> body {
+                bigint a = random_bits(bits), b = random_bits(bits), r;
+                return [=]() mutable {r = a - b; keep(r);};
+            }},
+            {"mul", [](size_t bits) -> body {
+                bigint a = random_bits(bits), b = random_bits(bits), r;
+                return [=]() mutable {r = a * b; keep(r);};
+            }},
+            {"square", [](size_t bits) -> body {
+                bigint a = random_bits(bits), r;
+                return [=]() mutable {r = a * a; keep(r);};
+            }},
+            {"div", [](size_t bits) -> body {
+                bigint a = random_bits(2 * bits), b = random_bits(bits), r;
+                return [=]() mutable {r = a / b; keep(r);};
+            }},
+            {"mod", [](size_t bits) -> body {
+                bigint a = random_bits(2 * bits), b = random_bits(bits), r;
+                return [=]() mutable {r = a % b; keep(r);};
+            }},
+            {"shift", [](size_t bits) -> body {
+                bigint a = random_bits(bits), r;
+                const size_t s = bits / 3 + 37;
+                return [=]() mutable {r = a << s; r >>= s + 5; keep(r);};
+            }},
+            {"pow", [](size_t bits) -> body {
+                bigint base = random_bits(64), r;
+                const bigint exp = (bits + 63) / 64;
+                return [=]() mutable {r = bigint::pow(base, exp); keep(r);};
+            }},
+            {"factorial", [](size_t bits) -> body {
+                const bigint n = factorial_arg(bits);
+                bigint r;
+                return [=]() mutable {r = bigint::factorial(n); keep(r);};
+            }},
+            {"to_string", [](size_t bits) -> body {
+                bigint a = random_bits(bits);
+                std::string r;
+                return [=]() mutable {r = a.to_string(); keep(r);};
+            }},
+            {"stobi", [](size_t bits) -> body {
+                const std::string s = random_bits(bits).to_string();
+                bigint r;
+                return [=]() mutable {r = stobi(s); keep(r);};
+            }},
+        };
+        return ops;
+    }
+
+    // Doubles the batch size until a batch takes at least 5 ms, then reports
+    // the fastest and median per-operation times over 5 batches.
+    result measure(const std::string& op, size_t bits, body& run) {
+        using clock = std::chrono::steady_clock;
+        auto time_batch = [&](size_t n) {
+            const clock::time_point start = clock::now();
+            for (size_t i = 0; i < n; i++) run();
+            return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        };
+
+        size_t iterations = 1;
+        while (time_batch(iterations) < 5e6 && iterations < (size_t(1) << 30)) iterations *= 2;
+        std::vector<double> samples;
+        for (int i = 0; i < 5; i++) {
+            samples.push_back(time_batch(iterations) / iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+        return {op, bits, iterations, samples.front(), samples[samples.size() / 2]};
+    }
+
+    void write_json(std::ostream& os, const std::vector<result>& results) {
+        os << "{\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const result& r = results[i];
+            os << "    {\"op\": \"" << r.op << "\", \"bits\": " << r.bits << ", \"iterations\": " << r.iterations
+               << ", \"ns_min\": " << r.ns_min << ", \"ns_median\": " << r.ns_median << "}"
+               << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n}\n";
+    }
+
+    void write_csv(std::ostream& os, const std::vector<result>& results) {
+        os << "op,bits,iterations,ns_min,ns_median\n";
+        for (const result& r : results) {
+            os << r.op << "," << r.bits << "," << r.iterations << "," << r.ns_min << "," << r.ns_median << "\n";
+        }
+    }
+
+    // The value after "key": on a line written by write_json.
+    std::string json_field(const std::string& line, const std::string& key) {
+        size_t pos = line.find("\"" + key + "\":");
+        if (pos == std::string::npos) return "";
+        pos = line.find_first_not_of(" \"", pos + key.size() + 3);
+        const size_t end = line.find_first_of(",\"}", pos);
+        return line.substr(pos, end - pos);
+    }
+
+    // Median times by (op, bits) from a file in either output format.
+    std::map<std::pair<std::string, size_t>, double> read_baseline(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open baseline " + path + ".");
+        std::map<std::pair<std::string, size_t>, double> baseline;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::string op, bits, ns;
+            if (line.find("\"op\":") != std::string::npos) {
+                op = json_field(line, "op");
+                bits = json_field(line, "bits");
+                ns = json_field(line, "ns_median");
+            } else if (!line.empty() && line.compare(0, 3, "op,") != 0) {
+                std::istringstream fields(line);
+                std::string iterations, ns_min;
+                std::getline(fields, op, ',');
+                std::getline(fields, bits, ',');
+                std::getline(fields, iterations, ',');
+                std::getline(fields, ns_min, ',');
+                std::getline(fields, ns, ',');
+            }
+            if (op.empty() || bits.empty() || ns.empty()) continue;
+            baseline[{op, std::stoull(bits)}] = std::stod(ns);
+        }
+        return baseline;
+    }
+
+    // Prints the ratio of each result to its baseline and returns whether any
+    // exceeds 1 + threshold.
+    bool compare(std::ostream& os, const std::vector<result>& results,
+                 const std::map<std::pair<std::string, size_t>, double>& baseline, double threshold) {
+        bool regressed = false;
+        os << "op          bits        baseline ns     current ns   ratio\n";
+        for (const result& r : results) {
+            const auto it = baseline.find({r.op, r.bits});
+            if (it == baseline.end()) continue;
+            const double ratio = r.ns_median / it->second;
+            const bool slower = ratio > 1 + threshold;
+            regressed |= slower;
+            char line[128];
+            std::snprintf(line, sizeof(line), "%-10s %9zu %15.1f %14.1f %7.3f%s\n",
+                          r.op.c_str(), r.bits, it->second, r.ns_median, ratio, slower ? "  REGRESSION" : "");
+            os << line;
+        }
+        return regressed;
+    }
+
+    [[noreturn]] void usage() {
+        std::cerr << "usage: bigint_bench [--format json|csv] [--output FILE] [--ops add,mul,...]\n"
+                     "                    [--min-bits N] [--max-bits N] [--baseline FILE]\n"
+                     "                    [--threshold FRACTION] [--threads N]\n";
+        std::exit(2);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string format = "json", output, baseline_path, op_list;
+    size_t min_bits = 64, max_bits = 10000000;
+    double threshold = 0.1;
+    size_t threads = bigint::tuning.threads;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 == argc) usage();
+        const std::string value = argv[++i];
+        if (arg == "--format") format = value;
+        else if (arg == "--output") output = value;
+        else if (arg == "--ops") op_list = value;
+        else if (arg == "--min-bits") min_bits = std::stoull(value);
+        else if (arg == "--max-bits") max_bits = std::stoull(value);
+        else if (arg == "--baseline") baseline_path = value;
+        else if (arg == "--threshold") threshold = std::stod(value);
+        else if (arg == "--threads") threads = std::stoull(value);
+        else usage();
+    }
+    if (format != "json" && format != "csv") usage();
+    if (min_bits == 0 || min_bits > max_bits) usage();
+    if (threads == 0) usage();
+    bigint::tuning.threads = threads;
+
+    // Sizes go up by factors of 4 from min_bits, ending with max_bits itself.
+    std::vector<size_t> sizes;
+    for (size_t bits = min_bits; bits < max_bits; bits *= 4) sizes.push_back(bits);
+    sizes.push_back(max_bits);
+
+    std::vector<result> results;
+    for (const auto& [name, make] : operations()) {
+        if (!op_list.empty() && ("," + op_list + ",").find("," + name + ",") == std::string::npos) continue;
+        for (size_t bits : sizes) {
+            body run = make(bits);
+            results.push_back(measure(name, bits, run));
+            std::cerr << name << " " << bits << " bits: " << results.back().ns_median << " ns\n";
+        }
+    }
+
+    std::ofstream file;
+    if (!output.empty()) file.open(output);
+    std::ostream& os = output.empty() ? std::cout : file;
+    if (format == "json") write_json(os, results);
+    else write_csv(os, results);
+
+    if (!baseline_path.empty()) {
+        return compare(std::cerr, results, read_baseline(baseline_path), threshold) ? 1 : 0;
+    }
+    return 0;
+}
@@ -1,955 +1,3806 @@
 #include "bigint.h"
 
-// MARK: Static Data Members
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// MARK: Limb Kernels
+
+namespace {
+    using limb = uint64_t;
+    using dlimb = unsigned __int128;
+
+    // r = a + b over n limbs, returning the carry out. r may alias a or b.
+    limb add_n(limb* r, const limb* a, const limb* b, size_t n) {
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb sum = static_cast<dlimb>(a[i]) + b[i] + carry;
+            r[i] = static_cast<limb>(sum);
+            carry = static_cast<limb>(sum >> 64);
+        }
+        return carry;
+    }
 
-const bigint bigint::zero;
+    // r = a + b where an >= bn, returning the carry out.
+    limb add(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+        limb carry = add_n(r, a, b, bn);
+        for (size_t i = bn; i < an; i++) {
+            r[i] = a[i] + carry;
+            carry = carry && !r[i];
+        }
+        return carry;
+    }
 
-// MARK: Private Helper Functions
+    // r = a - b over n limbs, returning the borrow out. r may alias a or b.
+    limb sub_n(limb* r, const limb* a, const limb* b, size_t n) {
+        limb borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb diff = static_cast<dlimb>(a[i]) - b[i] - borrow;
+            r[i] = static_cast<limb>(diff);
+            borrow = static_cast<limb>(diff >> 127);
+        }
+        return borrow;
+    }
 
-void bigint::grow() {
-    if (capacity == 0) {
-        capacity = 1;
-        array = new byte[1] {0};
-    } else {
-        byte* new_array = new byte[capacity + capacity] {0};
-        for (size_t i = 0; i < capacity; i++) {
-            new_array[i] = array[i];
+    // r = a - b where an >= bn, returning the borrow out.
+    limb sub(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+        limb borrow = sub_n(r, a, b, bn);
+        for (size_t i = bn; i < an; i++) {
+            const limb alimb = a[i];
+            r[i] = alimb - borrow;
+            borrow = borrow && !alimb;
         }
-        delete[] array;
-        array = new_array;
-        capacity += capacity;
+        return borrow;
     }
-}
 
-void bigint::trim() {
-    size_t i = num_bytes();
-    while (capacity && capacity >= (i << 1)) {
-        capacity >>= 1;
+    // r = a * b over n limbs, returning the high limb.
+    limb mul_1(limb* r, const limb* a, size_t n, limb b) {
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb prod = static_cast<dlimb>(a[i]) * b + carry;
+            r[i] = static_cast<limb>(prod);
+            carry = static_cast<limb>(prod >> 64);
+        }
+        return carry;
     }
-    byte* new_array = nullptr;
-    if (capacity) {
-        new_array = new byte[capacity] {0};
-        for (size_t i = 0; i < capacity; i++) {
-            new_array[i] = array[i];
+
+    // r += a * b over n limbs, returning the high limb.
+    limb addmul_1(limb* r, const limb* a, size_t n, limb b) {
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb prod = static_cast<dlimb>(a[i]) * b + r[i] + carry;
+            r[i] = static_cast<limb>(prod);
+            carry = static_cast<limb>(prod >> 64);
         }
+        return carry;
     }
-    delete[] array;
-    array = new_array;
-    if (!capacity) is_negative = false;
-}
 
-size_t bigint::num_bytes() const {
-    int i = capacity;
-    while (i > 0 && !array[i - 1]) --i;
-    return i;
-}
+    // r -= a * b over n limbs, returning the high limb that was borrowed.
+    limb submul_1(limb* r, const limb* a, size_t n, limb b) {
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb prod = static_cast<dlimb>(a[i]) * b + carry;
+            const limb lo = static_cast<limb>(prod);
+            carry = static_cast<limb>(prod >> 64) + (r[i] < lo);
+            r[i] -= lo;
+        }
+        return carry;
+    }
 
-// MARK: Constructors
+    // r = a << s over n > 0 limbs for 0 < s < 64, returning the bits shifted out
+    // of the top. Works down from the top, so r may overlap a from above.
+    limb lshift(limb* r, const limb* a, size_t n, unsigned int s) {
+        const limb out = a[n - 1] >> (64 - s);
+        for (size_t i = n - 1; i > 0; i--) {
+            r[i] = (a[i] << s) | (a[i - 1] >> (64 - s));
+        }
+        r[0] = a[0] << s;
+        return out;
+    }
 
-bigint::bigint()
-    :capacity(0), array(nullptr), is_negative(false) {}
+    // r = a >> s over n > 0 limbs for 0 < s < 64, returning the bits shifted out
+    // of the bottom in the high end of a limb. Works up from the bottom, so r
+    // may overlap a from below.
+    limb rshift(limb* r, const limb* a, size_t n, unsigned int s) {
+        const limb out = a[0] << (64 - s);
+        for (size_t i = 0; i + 1 < n; i++) {
+            r[i] = (a[i] >> s) | (a[i + 1] << (64 - s));
+        }
+        r[n - 1] = a[n - 1] >> s;
+        return out;
+    }
 
-bigint::bigint(char num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // floor((B^2 - 1) / d) - B for a divisor d with its top bit set, where B = 2^64.
+    limb reciprocal(limb d) {
+        return static_cast<limb>(~static_cast<dlimb>(0) / d);
     }
-}
 
-bigint::bigint(short num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // Divides the two-limb value (u1, u0) by the normalized divisor d, given
+    // v = reciprocal(d) and u1 < d. Stores the remainder in r and returns the quotient.
+    limb div_2by1(limb& r, limb u1, limb u0, limb d, limb v) {
+        const dlimb q = static_cast<dlimb>(v) * u1 + ((static_cast<dlimb>(u1) << 64) | u0);
+        limb q1 = static_cast<limb>(q >> 64) + 1;
+        const limb q0 = static_cast<limb>(q);
+        r = u0 - q1 * d;
+        if (r > q0) {
+            --q1;
+            r += d;
+        }
+        if (r >= d) {
+            ++q1;
+            r -= d;
+        }
+        return q1;
     }
-}
 
-bigint::bigint(int num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // q = u / d, where d has dn >= 2 limbs and its top bit set, and u has un >= dn
+    // limbs plus a top limb u[un] < d[dn - 1]. Writes un - dn + 1 quotient limbs
+    // and leaves the remainder in the low dn limbs of u.
+    void divrem(limb* q, limb* u, size_t un, const limb* d, size_t dn) {
+        const limb d1 = d[dn - 1];
+        const limb d0 = d[dn - 2];
+        const limb v = reciprocal(d1);
+        for (size_t j = un - dn + 1; j-- > 0; ) {
+            limb* uj = u + j;
+            const limb u2 = uj[dn];
+            const limb u1 = uj[dn - 1];
+            const limb u0 = uj[dn - 2];
+
+            // Estimate from the top two limbs, then correct with the third so the
+            // estimate is at most one too large.
+            limb qhat, rhat;
+            bool rhat_overflow = false;
+            if (u2 >= d1) {
+                qhat = ~static_cast<limb>(0);
+                rhat = u1 + d1;
+                rhat_overflow = rhat < u1;
+            } else {
+                qhat = div_2by1(rhat, u2, u1, d1, v);
+            }
+            while (!rhat_overflow && static_cast<dlimb>(qhat) * d0 > ((static_cast<dlimb>(rhat) << 64) | u0)) {
+                --qhat;
+                rhat += d1;
+                rhat_overflow = rhat < d1;
+            }
+
+            const limb borrow = submul_1(uj, d, dn, qhat);
+            uj[dn] = u2 - borrow;
+            if (u2 < borrow) {
+                --qhat;
+                uj[dn] += add_n(uj, uj, d, dn);
+            }
+            q[j] = qhat;
+        }
     }
-}
 
-bigint::bigint(long num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // The value of an alphanumeric digit, with letters from 10 upwards.
+    int digit_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+        return c - 'a' + 10;
     }
-}
 
-bigint::bigint(long long num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // Compares a and b by magnitude, returning -1, 0 or 1.
+    int cmp(const limb* a, size_t an, const limb* b, size_t bn) {
+        if (an != bn) return (an < bn) ? -1 : 1;
+        for (size_t i = an; i-- > 0; ) {
+            if (a[i] != b[i]) return (a[i] < b[i]) ? -1 : 1;
+        }
+        return 0;
     }
-}
 
-bigint::bigint(signed char num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(num < 0) {
-    if (is_negative) num = -num;
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // q = a / d over n limbs, returning the remainder. q may alias a.
+    limb divrem_1(limb* q, const limb* a, size_t n, limb d) {
+        if (!n) return 0;
+        const unsigned int shift = __builtin_clzll(d);
+        d <<= shift;
+        const limb v = reciprocal(d);
+        limb rem = shift ? a[n - 1] >> (64 - shift) : 0;
+        for (size_t i = n; i-- > 0; ) {
+            limb u0 = a[i] << shift;
+            if (shift && i) u0 |= a[i - 1] >> (64 - shift);
+            q[i] = div_2by1(rem, rem, u0, d, v);
+        }
+        return rem >> shift;
     }
-}
 
-bigint::bigint(unsigned char num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(false) {
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    // r = t / B^n mod m (Montgomery reduction), for t < m * B^n held in 2n + 1
+    // limbs with t[2n] = 0, an odd n-limb modulus m and m_inv = -1/m mod B.
+    // Destroys t; r may not overlap it.
+    void redc(limb* r, limb* t, const limb* m, size_t n, limb m_inv) {
+        for (size_t i = 0; i < n; i++) {
+            limb c = addmul_1(t + i, m, n, t[i] * m_inv);
+            for (size_t j = i + n; c; j++) {
+                t[j] += c;
+                c = t[j] < c;
+            }
+        }
+        if (t[2 * n] || cmp(t + n, n, m, n) >= 0) {
+            sub_n(r, t + n, m, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                r[i] = t[n + i];
+            }
+        }
     }
 }
 
-bigint::bigint(unsigned short num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(false) {
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+// MARK: Static Data Members
+
+const bigint bigint::zero;
+
+namespace {
+    // Holds products that cannot be built in their destination. operator*= trades
+    // buffers with it, so it keeps the last buffer released by that thread.
+    thread_local bigint product_scratch(std::pmr::new_delete_resource());
+}
+
+bigint::tuning_parameters bigint::tuning = {
+    BIGINT_KARATSUBA_THRESHOLD,
+    BIGINT_TOOM3_THRESHOLD,
+    BIGINT_TOOM4_THRESHOLD,
+    BIGINT_FFT_THRESHOLD,
+    BIGINT_NEWTON_THRESHOLD,
+    BIGINT_THREADS,
+    BIGINT_PARALLEL_THRESHOLD,
+    BIGINT_HGCD_THRESHOLD
+};
+
+// MARK: Statistics
+
+namespace {
+    constexpr bool stats_enabled = BIGINT_STATS;
+
+    // The counters are laid out as in bigint::statistics, which holds only
+    // uint64_t fields. Each thread bumps its own block without atomic
+    // read-modify-writes; stats() sums the live blocks with those of threads
+    // that have exited, and reset_stats() records the sums as a baseline to
+    // subtract, so no thread's counters are ever written by another.
+    constexpr size_t stat_fields = sizeof(bigint::statistics) / sizeof(uint64_t);
+    static_assert(stat_fields * sizeof(uint64_t) == sizeof(bigint::statistics), "statistics holds only uint64_t fields");
+
+    constexpr size_t calls_at = offsetof(bigint::statistics, calls) / sizeof(uint64_t);
+    constexpr size_t allocations_at = offsetof(bigint::statistics, allocations) / sizeof(uint64_t);
+    constexpr size_t allocated_bytes_at = offsetof(bigint::statistics, allocated_bytes) / sizeof(uint64_t);
+    constexpr size_t reallocations_at = offsetof(bigint::statistics, reallocations) / sizeof(uint64_t);
+    constexpr size_t reallocated_bytes_at = offsetof(bigint::statistics, reallocated_bytes) / sizeof(uint64_t);
+    constexpr size_t trims_at = offsetof(bigint::statistics, trims) / sizeof(uint64_t);
+    constexpr size_t trimmed_bytes_at = offsetof(bigint::statistics, trimmed_bytes) / sizeof(uint64_t);
+    constexpr size_t multiply_sizes_at = offsetof(bigint::statistics, multiply_sizes) / sizeof(uint64_t);
+    constexpr size_t divide_sizes_at = offsetof(bigint::statistics, divide_sizes) / sizeof(uint64_t);
+    constexpr size_t convert_sizes_at = offsetof(bigint::statistics, convert_sizes) / sizeof(uint64_t);
+    constexpr size_t tier_calls_at = offsetof(bigint::statistics, tier_calls) / sizeof(uint64_t);
+    constexpr size_t tier_ns_at = offsetof(bigint::statistics, tier_ns) / sizeof(uint64_t);
+
+    struct stat_block {
+        std::atomic<uint64_t> counts[stat_fields] = {};
+    };
+
+    struct stat_registry {
+        std::mutex lock;
+        std::vector<const stat_block*> live;
+        uint64_t retired[stat_fields] = {};
+        uint64_t baseline[stat_fields] = {};
+
+        void sum(uint64_t* totals) {
+            for (size_t i = 0; i < stat_fields; i++) {
+                totals[i] = retired[i];
+            }
+            for (const stat_block* b : live) {
+                for (size_t i = 0; i < stat_fields; i++) {
+                    totals[i] += b->counts[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    // Never destroyed, so threads exiting during static destruction can still
+    // retire their blocks.
+    stat_registry& registry() {
+        static stat_registry* r = new stat_registry;
+        return *r;
     }
-}
 
-bigint::bigint(unsigned int num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(false) {
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    struct thread_stats {
+        stat_block block;
+
+        thread_stats() {
+            stat_registry& r = registry();
+            const std::lock_guard<std::mutex> guard(r.lock);
+            r.live.push_back(&block);
+        }
+        ~thread_stats() {
+            stat_registry& r = registry();
+            const std::lock_guard<std::mutex> guard(r.lock);
+            for (size_t i = 0; i < stat_fields; i++) {
+                r.retired[i] += block.counts[i].load(std::memory_order_relaxed);
+            }
+            r.live.erase(std::find(r.live.begin(), r.live.end(), &block));
+        }
+    };
+    thread_local thread_stats local_stats;
+
+    // The operation charged for this thread's work, and how deep this thread is
+    // in multiplications and divisions. Pool workers start at depth 1, since
+    // their subproducts belong to a multiplication timed by its caller.
+    thread_local bigint::operation current_operation = bigint::operation::other;
+    thread_local bool in_operation = false;
+    thread_local size_t multiply_depth = 0;
+    thread_local size_t divide_depth = 0;
+
+    void count(size_t field, uint64_t n = 1) {
+        std::atomic<uint64_t>& c = local_stats.block.counts[field];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
     }
-}
 
-bigint::bigint(unsigned long num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(false) {
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    void count_size(size_t histogram, size_t n) {
+        size_t i = n ? 64 - __builtin_clzll(n) : 0;
+        if (i >= bigint::statistics::buckets) i = bigint::statistics::buckets - 1;
+        count(histogram + i);
     }
-}
 
-bigint::bigint(unsigned long long num)
-    :capacity(sizeof(num)), array(new byte[sizeof(num)]), is_negative(false) {
-    for (size_t i = 0; i < capacity; i++) {
-        array[i] = (num >> (i << 3)) & 0xFF;
+    void count_allocation(size_t bytes) {
+        const size_t op = static_cast<size_t>(in_operation ? current_operation : bigint::operation::other);
+        count(allocations_at + op);
+        count(allocated_bytes_at + op, bytes);
     }
-}
 
-// MARK: Rule of 5
+    // Charges the thread's work to op for its lifetime unless an enclosing
+    // operation already claimed it.
+    class operation_scope {
+        private:
+            bool outermost = false;
+        public:
+            explicit operation_scope(bigint::operation op) {
+                if constexpr (stats_enabled) {
+                    if (in_operation) return;
+                    in_operation = outermost = true;
+                    current_operation = op;
+                    count(calls_at + static_cast<size_t>(op));
+                }
+            }
+            ~operation_scope() {
+                if constexpr (stats_enabled) {
+                    if (outermost) in_operation = false;
+                }
+            }
+            operation_scope(const operation_scope&) = delete;
+            operation_scope& operator=(const operation_scope&) = delete;
+    };
 
-bigint::bigint(const bigint& other)
-    :capacity(other.capacity), array(other.capacity ? new byte[other.capacity] : nullptr), is_negative(other.is_negative) {
-    if (capacity) {
-        for (size_t i = 0; i < capacity; i++) {
-            array[i] = other.array[i];
-        }
+    // Times the tier passed to start when this is the outermost scope on depth,
+    // and records the operand size in histogram.
+    class tier_scope {
+        private:
+            size_t& depth;
+            int active = -1;
+            std::chrono::steady_clock::time_point begin;
+        public:
+            explicit tier_scope(size_t& depth) : depth(depth) {
+                if constexpr (stats_enabled) ++depth;
+            }
+            void start(bigint::tier t, size_t histogram, size_t n, bool timed = true) {
+                if constexpr (stats_enabled) {
+                    if (depth != 1) return;
+                    count(tier_calls_at + static_cast<size_t>(t));
+                    count_size(histogram, n);
+                    if (!timed) return;
+                    active = static_cast<int>(t);
+                    begin = std::chrono::steady_clock::now();
+                }
+            }
+            ~tier_scope() {
+                if constexpr (stats_enabled) {
+                    --depth;
+                    if (active < 0) return;
+                    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+                    count(tier_ns_at + active, ns.count());
+                }
+            }
+            tier_scope(const tier_scope&) = delete;
+            tier_scope& operator=(const tier_scope&) = delete;
     };
 }
 
-bigint::bigint(bigint&& other)
-    :capacity(other.capacity), array(other.array), is_negative(other.is_negative) {
-    other.capacity = 0;
-    other.array = nullptr;
+bigint::statistics bigint::stats() {
+    uint64_t totals[stat_fields];
+    stat_registry& r = registry();
+    {
+        const std::lock_guard<std::mutex> guard(r.lock);
+        r.sum(totals);
+        for (size_t i = 0; i < stat_fields; i++) {
+            totals[i] -= r.baseline[i];
+        }
+    }
+    statistics s;
+    std::memcpy(&s, totals, sizeof(s));
+    return s;
 }
 
-bigint::~bigint() {
-    delete[] array;
+void bigint::reset_stats() {
+    stat_registry& r = registry();
+    const std::lock_guard<std::mutex> guard(r.lock);
+    r.sum(r.baseline);
 }
 
-bigint& bigint::operator = (const bigint& other) {
-    if (&other == this) return *this;
+// MARK: Private Helper Functions
 
-    delete[] array;
-    capacity = other.capacity;
-    if (capacity) {
-        array = new byte[capacity];
-        for (size_t i = 0; i < capacity; i++) {
-            array[i] = other.array[i];
-        }
-    } else array = nullptr;
-    is_negative = other.is_negative;
+namespace {
+    // Set by bigint::set_default_resource, or null for std::pmr's default, and
+    // the same resource if it is a bigint_mmap_resource.
+    thread_local std::pmr::memory_resource* thread_resource = nullptr;
+    thread_local bigint_mmap_resource* thread_mapped = nullptr;
+
+    // The resource as a bigint_mmap_resource, or null. Reserve and trim ask on
+    // every reallocation, so the heap and the thread's default, which back
+    // nearly every number, are recognized by address; only other resources
+    // passed in explicitly need a dynamic_cast.
+    bigint_mmap_resource* as_mapped(std::pmr::memory_resource* mr) {
+        if (mr == thread_resource) return thread_mapped;
+        if (mr == std::pmr::new_delete_resource()) return nullptr;
+        return dynamic_cast<bigint_mmap_resource*>(mr);
+    }
+}
 
-    return *this;
+bigint::limb* bigint::allocate(size_t n) {
+    if constexpr (stats_enabled) count_allocation(n * sizeof(limb));
+    return static_cast<limb*>(resource->allocate(n * sizeof(limb), alignof(limb)));
 }
 
-bigint& bigint::operator = (bigint&& other) {
-    if (&other == this) return *this;
+void bigint::deallocate(limb* p, size_t n) {
+    resource->deallocate(p, n * sizeof(limb), alignof(limb));
+}
 
-    delete[] array;
-    capacity = other.capacity;
-    array = other.array;
-    is_negative = other.is_negative;
+void bigint::grow() {
+    reserve(capacity ? capacity + capacity : 1);
+}
 
-    other.capacity = 0;
-    other.array = nullptr;
-    
-    return *this;
+void bigint::reserve(size_t n) {
+    if (n <= capacity) return;
+    if (n <= inline_limbs) {
+        for (size_t i = capacity; i < n; i++) {
+            local[i] = 0;
+        }
+        capacity = n;
+        return;
+    }
+    if (remap(n)) return;
+    limb* new_array = allocate(n);
+    if constexpr (stats_enabled) {
+        if (capacity) {
+            count(reallocations_at);
+            count(reallocated_bytes_at, capacity * sizeof(limb));
+        }
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        new_array[i] = array[i];
+    }
+    for (size_t i = capacity; i < n; i++) {
+        new_array[i] = 0;
+    }
+    if (array != local) deallocate(array, capacity);
+    array = new_array;
+    capacity = n;
 }
 
-// MARK: Conversion Operators
+void bigint::trim() {
+    normalize(capacity);
+    const size_t i = limb_count;
+    size_t new_capacity = capacity;
+    while (new_capacity && new_capacity >= (i << 1)) {
+        new_capacity >>= 1;
+    }
+    if (new_capacity != capacity && !remap(new_capacity)) {
+        limb* new_array = (new_capacity > inline_limbs) ? allocate(new_capacity) : local;
+        if (new_array != array) {
+            if constexpr (stats_enabled) {
+                count(trims_at);
+                count(trimmed_bytes_at, new_capacity * sizeof(limb));
+            }
+            for (size_t i = 0; i < new_capacity; i++) {
+                new_array[i] = array[i];
+            }
+            if (array != local) deallocate(array, capacity);
+            array = new_array;
+        }
+        capacity = new_capacity;
+    }
+}
 
-bigint::operator bool() const {
-    return this->operator!=(zero);
+bool bigint::remap(size_t n) {
+    // Resizes heap storage in place when the resource can do so without
+    // copying. Limbs past the old capacity come back zero, since the ones
+    // dropped by earlier shrinks were.
+    if (array == local || n <= inline_limbs) return false;
+    bigint_mmap_resource* mapped = as_mapped(resource);
+    if (!mapped) return false;
+    void* p = mapped->reallocate(array, capacity * sizeof(limb), n * sizeof(limb), alignof(limb));
+    if (!p) return false;
+    array = static_cast<limb*>(p);
+    capacity = n;
+    return true;
 }
 
-bigint::operator char() const {
-    if (std::numeric_limits<char>().min() == 0) return this->operator unsigned char();
-    else return this->operator signed char();
+void bigint::normalize(size_t n) {
+    // Recounts the limbs after they were written directly, given that those
+    // from n up are zero.
+    while (n > 0 && !array[n - 1]) --n;
+    limb_count = n;
+    if (!n) is_negative = false;
 }
 
-bigint::operator short() const {
-    using T = short;
-    using U = unsigned short;
+size_t bigint::num_limbs() const {
+    return limb_count;
+}
 
-    U result_u = is_negative ? -*this : *this;
-    if (is_negative) --result_u;
-    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
-    T result = result_u;
-    if (is_negative) result = -result - 1;
-    return result;
+size_t bigint::bit_length() const {
+    const size_t n = num_limbs();
+    return n ? 64 * n - __builtin_clzll(array[n - 1]) : 0;
 }
 
-bigint::operator int() const {
-    using T = int;
-    using U = unsigned int;
+bigint::limb bigint::div_limb(limb d) {
+    const size_t n = num_limbs();
+    const limb rem = divrem_1(array, array, n, d);
+    normalize(n);
+    return rem;
+}
 
-    U result_u = is_negative ? -*this : *this;
-    if (is_negative) --result_u;
-    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
-    T result = result_u;
-    if (is_negative) result = -result - 1;
+bigint bigint::from_limbs(const limb* src, size_t n) {
+    while (n > 0 && !src[n - 1]) --n;
+    bigint result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        result.array[i] = src[i];
+    }
+    result.limb_count = n;
     return result;
 }
 
-bigint::operator long() const {
-    using T = long;
-    using U = unsigned long;
-
-    U result_u = is_negative ? -*this : *this;
-    if (is_negative) --result_u;
-    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
-    T result = result_u;
-    if (is_negative) result = -result - 1;
-    return result;
+void bigint::signed_add(bigint& result, const bigint& a, bool a_negative, const bigint& b, bool b_negative) {
+    signed_add(result, a.array, a.num_limbs(), a_negative, b.array, b.num_limbs(), b_negative);
 }
 
-bigint::operator long long() const {
-    using T = long long;
-    using U = unsigned long long;
+void bigint::signed_add(bigint& result, const limb* a, size_t an, bool a_negative, const limb* b, size_t bn, bool b_negative) {
+    // result = (+/-)a + (+/-)b with the signs given separately, so neither operand
+    // has to be copied to flip it.
+    const operation_scope scope(operation::add);
+    const bool a_larger = cmp(a, an, b, bn) >= 0;
+    const limb* larger = a_larger ? a : b;
+    const limb* smaller = a_larger ? b : a;
+    const size_t ln = a_larger ? an : bn;
+    const size_t sn = a_larger ? bn : an;
 
-    U result_u = is_negative ? -*this : *this;
-    if (is_negative) --result_u;
-    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
-    T result = result_u;
-    if (is_negative) result = -result - 1;
-    return result;
+    if (result.capacity < ln + 1 && (a == result.array || b == result.array)) {
+        // Growing result would free an operand.
+        bigint tmp;
+        signed_add(tmp, a, an, a_negative, b, bn, b_negative);
+        result = std::move(tmp);
+        return;
+    }
+    result.reserve(ln + 1);
+    if (a_negative == b_negative) {
+        result.array[ln] = add(result.array, larger, ln, smaller, sn);
+    } else {
+        sub(result.array, larger, ln, smaller, sn);
+        result.array[ln] = 0;
+    }
+    result.is_negative = a_larger ? a_negative : b_negative;
+    result.normalize(ln + 1);
 }
 
-bigint::operator signed char() const {
-    using T = signed char;
-    using U = unsigned char;
+void bigint::multiply_into(bigint& dest, const bigint& a, const bigint& b) {
+    const operation_scope scope(operation::multiply);
+    // dest = a * b, reusing dest's storage when it is large enough.
+    if (&dest == &a || &dest == &b) {
+        dest = a * b;
+        return;
+    }
+    const size_t an = a.num_limbs();
+    const size_t bn = b.num_limbs();
+    if (!an || !bn) {
+        dest = zero;
+        return;
+    }
 
-    U result_u = is_negative ? -*this : *this;
-    if (is_negative) --result_u;
-    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
-    T result = result_u;
-    if (is_negative) result = -result - 1;
-    return result;
-}
+    if (dest.capacity < an + bn) {
+        dest = zero;
+        dest.reserve(an + bn);
+    }
+    mul_limbs(dest.array, a.array, an, b.array, bn);
+    for (size_t i = an + bn; i < dest.capacity; i++) {
+        dest.array[i] = 0;
+    }
+    dest.is_negative = a.is_negative != b.is_negative;
+    dest.trim();
+}
+
+void bigint::fused_multiply_add(bigint& dest, const bigint& a, const bigint& b, bool negate) {
+    const operation_scope scope(operation::multiply);
+    // dest += a * b, or dest -= a * b if negate is set.
+    const limb* ap = a.array;
+    const limb* bp = b.array;
+    size_t an = a.num_limbs();
+    size_t bn = b.num_limbs();
+    if (!an || !bn) return;
+    const bool product_negative = (a.is_negative != b.is_negative) != negate;
+    if (an < bn) {
+        std::swap(ap, bp);
+        std::swap(an, bn);
+    }
 
-bigint::operator unsigned char() const {
-    using T = unsigned char;
+    if (bn >= tuning.karatsuba_threshold || &dest == &a || &dest == &b) {
+        product_scratch.reserve(an + bn);
+        mul_limbs(product_scratch.array, ap, an, bp, bn);
+        for (size_t i = an + bn; i < product_scratch.capacity; i++) {
+            product_scratch.array[i] = 0;
+        }
+        product_scratch.normalize(an + bn);
+        signed_add(dest, dest, dest.is_negative, product_scratch, product_negative);
+        return;
+    }
 
-    const size_t max = sizeof(T);
-    T result = 0;
-    if (is_negative) {
-        for (size_t i = 0; i < capacity; i++) {
-            if (array[i]) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    // Small products are accumulated row by row straight into dest. When the
+    // signs differ the rows are subtracted, and a borrow out of the top limb
+    // means the result changed sign and is held in two's complement.
+    const size_t dn = dest.num_limbs();
+    const size_t n = ((dn > an + bn) ? dn : an + bn) + 1;
+    const bool subtract = dn && dest.is_negative != product_negative;
+    dest.reserve(n);
+    limb borrow = 0;
+    for (size_t i = 0; i < bn; i++) {
+        limb* r = dest.array + i;
+        limb c = subtract ? submul_1(r, ap, an, bp[i]) : addmul_1(r, ap, an, bp[i]);
+        for (size_t j = an; c && i + j < n; j++) {
+            const limb x = r[j];
+            r[j] = subtract ? x - c : x + c;
+            c = subtract ? (x < c) : (r[j] < c);
         }
-    } else {
-        size_t i = num_bytes();
-        if (i > max) throw std::overflow_error("Conversion failed: bigint is too large");
-        while (i-- > 0) {
-            result <<= 8;
-            result |= array[i];
+        borrow |= c;
+    }
+
+    if (borrow) {
+        for (size_t i = 0; i < n; i++) {
+            dest.array[i] = ~dest.array[i];
         }
+        size_t i = 0;
+        while (i < n && !++dest.array[i]) ++i;
+        dest.is_negative = product_negative;
+    } else if (!dn) {
+        dest.is_negative = product_negative;
     }
-    return result;
+    dest.normalize(n);
 }
 
-bigint::operator unsigned short() const {
-    using T = unsigned short;
+void bigint::divide(const bigint& lhs, const bigint& rhs, bigint* quot, bigint* rem) {
+    const size_t ln = lhs.num_limbs();
+    const size_t rn = rhs.num_limbs();
+    if (!rn) throw std::invalid_argument("Divide by zero error.");
 
-    const size_t max = sizeof(T);
-    T result = 0;
-    if (is_negative) {
-        for (size_t i = 0; i < capacity; i++) {
-            if (array[i]) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
-        }
+    const operation_scope scope(operation::divide);
+    tier_scope timer(divide_depth);
+    bigint q, r;
+    if (rn >= tuning.newton_threshold && ln >= rn + tuning.newton_threshold) {
+        timer.start(tier::newton, divide_sizes_at, ln);
+        divide_newton(lhs, rhs, newton_reciprocal(rhs), q, r);
     } else {
-        size_t i = num_bytes();
-        if (i > max) throw std::overflow_error("Conversion failed: bigint is too large");
-        while (i-- > 0) {
-            result <<= 8;
-            result |= array[i];
-        }
+        timer.start(tier::knuth, divide_sizes_at, ln, rn >= tuning.karatsuba_threshold);
+        divide_knuth(lhs, rhs, q, r);
+    }
+
+    if (quot) {
+        q.is_negative = lhs.is_negative != rhs.is_negative;
+        q.trim();
+        *quot = std::move(q);
+    }
+    if (rem) {
+        r.is_negative = lhs.is_negative;
+        r.trim();
+        *rem = std::move(r);
     }
-    return result;
 }
 
-bigint::operator unsigned int() const {
-    using T = unsigned int;
+// The division helpers below work on magnitudes and ignore the operands' signs.
 
-    const size_t max = sizeof(T);
-    T result = 0;
-    if (is_negative) {
-        for (size_t i = 0; i < capacity; i++) {
-            if (array[i]) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+void bigint::divide_knuth(const bigint& a, const bigint& d, bigint& q, bigint& r) {
+    const size_t an = a.num_limbs();
+    const size_t dn = d.num_limbs();
+    q = zero;
+    if (an < dn) {
+        r = from_limbs(a.array, an);
+        return;
+    }
+
+    q.reserve(an - dn + 1);
+    if (dn == 1) {
+        r = divrem_1(q.array, a.array, an, d.array[0]);
+        q.normalize(an);
+        return;
+    }
+
+    // Knuth's Algorithm D. Normalize so the divisor's top bit is set, giving the
+    // dividend a spare limb, and keep the remainder in r.
+    const unsigned int shift = __builtin_clzll(d.array[dn - 1]);
+    bigint dnorm = from_limbs(d.array, dn);
+    dnorm <<= shift;
+    r = from_limbs(a.array, an);
+    r.reserve(an + 1);
+    r <<= shift;
+    divrem(q.array, r.array, an, dnorm.array, dn);
+    q.normalize(an - dn + 1);
+    r.normalize(an + 1);
+    r >>= shift;
+}
+
+void bigint::divide_newton(const bigint& a, const bigint& d, const bigint& inv, bigint& q, bigint& r) {
+    // Barrett reduction with inv = floor(B^2n / d): for t < d * B^n the estimate
+    // below is at most two short of the true quotient. Longer dividends are
+    // divided n limbs at a time, like schoolbook division in base B^n.
+    const size_t an = a.num_limbs();
+    const size_t n = d.num_limbs();
+    const bigint dm = from_limbs(d.array, n);
+    auto step = [&](const bigint& t, bigint& tq, bigint& tr) {
+        tq = ((t >> (64 * (n - 1))) * inv) >> (64 * (n + 1));
+        tr = t - tq * dm;
+        while (tr >= dm) {
+            tr -= dm;
+            ++tq;
         }
-    } else {
-        size_t i = num_bytes();
-        if (i > max) throw std::overflow_error("Conversion failed: bigint is too large");
-        while (i-- > 0) {
-            result <<= 8;
-            result |= array[i];
+    };
+
+    if (an <= 2 * n) {
+        step(from_limbs(a.array, an), q, r);
+        return;
+    }
+
+    const size_t blocks = (an - 1) / n;
+    bigint tq;
+    step(from_limbs(a.array + blocks * n, an - blocks * n), tq, r);
+    q = zero;
+    q.reserve(blocks * n + 1);
+    q.array[blocks * n] = tq.num_limbs() ? tq.array[0] : 0;
+    for (size_t i = blocks; i-- > 0; ) {
+        step((r << (64 * n)) + from_limbs(a.array + i * n, n), tq, r);
+        for (size_t j = 0; j < tq.num_limbs(); j++) {
+            q.array[i * n + j] = tq.array[j];
         }
     }
-    return result;
-}
+    q.trim();
+}
+
+bigint bigint::newton_reciprocal(const bigint& d) {
+    // floor(B^2n / d) for an n-limb d. The reciprocal of the top h limbs, shifted
+    // into place, is refined by one Newton step x += x * (B^2n - d * x) / B^2n and
+    // then corrected to the exact floor. Taking h a little over n / 2 keeps the
+    // correction to a few steps. Below the Newton threshold, plain long division
+    // is cheaper.
+    const size_t n = d.num_limbs();
+    bigint power;
+    power.reserve(2 * n + 1);
+    power.array[2 * n] = 1;
+    power.normalize(2 * n + 1);
+    const bigint dm = from_limbs(d.array, n);
+
+    bigint x;
+    if (n <= 8 || n < tuning.newton_threshold) {
+        bigint r;
+        divide_knuth(power, dm, x, r);
+        return x;
+    }
 
-bigint::operator unsigned long() const {
-    using T = unsigned long;
+    const size_t h = n / 2 + 2;
+    x = newton_reciprocal(from_limbs(d.array + (n - h), h)) << (64 * (n - h));
+    x += (x * (power - dm * x)) >> (128 * n);
 
-    const size_t max = sizeof(T);
-    T result = 0;
-    if (is_negative) {
-        for (size_t i = 0; i < capacity; i++) {
-            if (array[i]) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    bigint e = power - dm * x;
+    while (e < 0) {
+        e += dm;
+        --x;
+    }
+    while (e >= dm) {
+        e -= dm;
+        ++x;
+    }
+    return x;
+}
+
+// MARK: Parallel Execution
+
+namespace {
+    // A work-stealing pool for large multiplications. Each worker pushes and pops
+    // tasks at the back of its own deque and steals from the front of the others
+    // when it runs dry. Threads outside the pool hand tasks out round-robin.
+    class thread_pool {
+        private:
+            struct queue {
+                std::mutex lock;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<queue>> queues;
+            std::vector<std::thread> threads;
+            std::atomic<size_t> queued{0};
+            std::atomic<size_t> next{0};
+            std::mutex sleep_lock;
+            std::condition_variable wake;
+            bool stopping = false;
+
+            bool take(size_t, std::function<void()>&);
+            void work(size_t);
+        public:
+            explicit thread_pool(size_t);
+            ~thread_pool();
+
+            size_t size() const {return threads.size();}
+            void push(std::function<void()>);
+            bool run_one();
+    };
+
+    // The pool and queue index of a worker thread.
+    thread_local thread_pool* current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+
+    thread_pool::thread_pool(size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            queues.emplace_back(new queue);
         }
-    } else {
-        size_t i = num_bytes();
-        if (i > max) throw std::overflow_error("Conversion failed: bigint is too large");
-        while (i-- > 0) {
-            result <<= 8;
-            result |= array[i];
+        for (size_t i = 0; i < n; i++) {
+            threads.emplace_back(&thread_pool::work, this, i);
         }
     }
-    return result;
-}
 
-bigint::operator unsigned long long() const {
-    using T = unsigned long long;
+    thread_pool::~thread_pool() {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
 
-    const size_t max = sizeof(T);
-    T result = 0;
-    if (is_negative) {
-        for (size_t i = 0; i < capacity; i++) {
-            if (array[i]) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    void thread_pool::push(std::function<void()> task) {
+        const size_t i = (current_pool == this) ? current_worker : next++ % queues.size();
+        {
+            std::lock_guard<std::mutex> guard(queues[i]->lock);
+            queues[i]->tasks.push_back(std::move(task));
         }
-    } else {
-        size_t i = num_bytes();
-        if (i > max) throw std::overflow_error("Conversion failed: bigint is too large");
-        while (i-- > 0) {
-            result <<= 8;
-            result |= array[i];
+        ++queued;
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
         }
+        wake.notify_one();
     }
-    return result;
-}
 
-// MARK: Unary Operators
+    bool thread_pool::take(size_t self, std::function<void()>& task) {
+        const size_t n = queues.size();
+        if (self < n) {
+            std::lock_guard<std::mutex> guard(queues[self]->lock);
+            if (!queues[self]->tasks.empty()) {
+                task = std::move(queues[self]->tasks.back());
+                queues[self]->tasks.pop_back();
+                --queued;
+                return true;
+            }
+        }
+        const size_t start = (self < n) ? self + 1 : next.load();
+        for (size_t k = 0; k < n; k++) {
+            queue& victim = *queues[(start + k) % n];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
 
-bigint bigint::operator + () const {
-    bigint result = *this;
-    return result;
+    bool thread_pool::run_one() {
+        std::function<void()> task;
+        if (!take((current_pool == this) ? current_worker : queues.size(), task)) return false;
+        task();
+        return true;
+    }
+
+    void thread_pool::work(size_t id) {
+        current_pool = this;
+        current_worker = id;
+        multiply_depth = 1;
+        std::function<void()> task;
+        for (;;) {
+            if (take(id, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleep_lock);
+            wake.wait(guard, [this] {return stopping || queued.load() > 0;});
+            if (stopping && !queued.load()) return;
+        }
+    }
+
+    // Built on first use with bigint::tuning.threads - 1 workers, since the
+    // calling thread works too.
+    std::mutex pool_lock;
+    std::unique_ptr<thread_pool> pool_instance;
+
+    thread_pool& pool() {
+        if (current_pool) return *current_pool;
+        std::lock_guard<std::mutex> guard(pool_lock);
+        if (!pool_instance || pool_instance->size() + 1 != bigint::tuning.threads) {
+            pool_instance.reset();
+            pool_instance.reset(new thread_pool(bigint::tuning.threads - 1));
+        }
+        return *pool_instance;
+    }
+
+    bool parallel(size_t n) {
+        return bigint::tuning.threads > 1 && n >= bigint::tuning.parallel_threshold;
+    }
+
+    // Fork-join over the pool. wait() runs queued tasks instead of blocking, so
+    // tasks may fork groups of their own, and rethrows the first exception.
+    class task_group {
+        private:
+            thread_pool& owner;
+            std::atomic<size_t> pending{0};
+            std::mutex lock;
+            std::exception_ptr error;
+
+            void finish() {
+                while (pending.load()) {
+                    if (!owner.run_one()) std::this_thread::yield();
+                }
+            }
+        public:
+            task_group() : owner(pool()) {}
+            ~task_group() {finish();}
+
+            template<typename F> void run(F f) {
+                ++pending;
+                owner.push([this, f] {
+                    try {
+                        f();
+                    } catch (...) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (!error) error = std::current_exception();
+                    }
+                    --pending;
+                });
+            }
+
+            void wait() {
+                finish();
+                if (error) std::rethrow_exception(error);
+            }
+    };
+}
+
+void bigint::multiply_all(bigint* const* out, const bigint* const* x, const bigint* const* y, size_t k, size_t n) {
+    // out[i] = x[i] * y[i] for i < k. In parallel, the products are built in
+    // buffers from the thread-safe new_delete_resource, since the destinations'
+    // resources may only be used from the calling thread.
+    if (!parallel(n)) {
+        for (size_t i = 0; i < k; i++) {
+            multiply_into(*out[i], *x[i], *y[i]);
+        }
+        return;
+    }
+
+    std::vector<bigint> products;
+    products.reserve(k);
+    for (size_t i = 0; i < k; i++) {
+        products.emplace_back(std::pmr::new_delete_resource());
+    }
+    task_group group;
+    for (size_t i = 1; i < k; i++) {
+        group.run([&products, x, y, i] {multiply_into(products[i], *x[i], *y[i]);});
+    }
+    multiply_into(products[0], *x[0], *y[0]);
+    group.wait();
+    for (size_t i = 0; i < k; i++) {
+        *out[i] = std::move(products[i]);
+    }
+}
+
+// MARK: Multiplication Algorithms
+
+// All of these write the full an + bn limb product to r, which must not overlap
+// either operand.
+
+void bigint::mul_limbs(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    tier_scope timer(multiply_depth);
+    const size_t sizes = multiply_sizes_at;
+    if (bn < tuning.karatsuba_threshold) {
+        timer.start(tier::basecase, sizes, an, false);
+        mul_basecase(r, a, an, b, bn);
+    } else if (bn >= tuning.fft_threshold) {
+        timer.start(tier::ntt, sizes, an);
+        mul_ntt(r, a, an, b, bn);
+    } else if (bn <= (an + 1) / 2) {
+        // Too unbalanced to split evenly, so multiply b by bn-limb slices of a.
+        timer.start(tier::unbalanced, sizes, an);
+        bigint tmp;
+        tmp.reserve(bn + bn);
+        for (size_t i = 0; i < an + bn; i++) {
+            r[i] = 0;
+        }
+        for (size_t i = 0; i < an; i += bn) {
+            const size_t n = (an - i < bn) ? an - i : bn;
+            mul_limbs(tmp.array, a + i, n, b, bn);
+            add(r + i, r + i, an + bn - i, tmp.array, n + bn);
+        }
+    } else if (bn < tuning.toom3_threshold) {
+        timer.start(tier::karatsuba, sizes, an);
+        mul_karatsuba(r, a, an, b, bn);
+    } else if (bn < tuning.toom4_threshold) {
+        timer.start(tier::toom3, sizes, an);
+        mul_toom3(r, a, an, b, bn);
+    } else {
+        timer.start(tier::toom4, sizes, an);
+        mul_toom4(r, a, an, b, bn);
+    }
+}
+
+void bigint::mul_basecase(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    r[bn] = mul_1(r, b, bn, a[0]);
+    for (size_t i = 1; i < an; i++) {
+        r[i + bn] = addmul_1(r + i, b, bn, a[i]);
+    }
+}
+
+void bigint::mul_karatsuba(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    // a = a1 * B^h + a0 and b = b1 * B^h + b0, with (a0 + a1)(b0 + b1) - a0 * b0 - a1 * b1
+    // supplying the middle term. Requires an >= bn > h.
+    const size_t h = (an + 1) / 2;
+    const size_t ah = an - h;
+    const size_t bh = bn - h;
+
+    bigint tmp;
+    tmp.reserve(4 * (h + 1));
+    limb* sa = tmp.array;
+    limb* sb = sa + h + 1;
+    limb* mid = sb + h + 1;
+    sa[h] = add(sa, a, h, a + h, ah);
+    sb[h] = add(sb, b, h, b + h, bh);
+    const size_t san = h + (sa[h] ? 1 : 0);
+    const size_t sbn = h + (sb[h] ? 1 : 0);
+
+    // The three products write disjoint limbs, so they can run side by side.
+    if (parallel(bn)) {
+        task_group group;
+        group.run([=] {mul_limbs(r, a, h, b, h);});
+        group.run([=] {mul_limbs(r + h + h, a + h, ah, b + h, bh);});
+        mul_limbs(mid, sa, san, sb, sbn);
+        group.wait();
+    } else {
+        mul_limbs(r, a, h, b, h);
+        mul_limbs(r + h + h, a + h, ah, b + h, bh);
+        mul_limbs(mid, sa, san, sb, sbn);
+    }
+
+    const size_t mn = san + sbn;
+    sub(mid, mid, mn, r, h + h);
+    sub(mid, mid, mn, r + h + h, ah + bh);
+    add(r + h, r + h, an + bn - h, mid, (mn < an + bn - h) ? mn : an + bn - h);
+}
+
+void bigint::mul_toom3(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    // Split into thirds, evaluate at 0, 1, -1, -2 and infinity, and interpolate
+    // with Bodrato's sequence. The divisions are exact.
+    const size_t s = (an + 2) / 3;
+    bigint ap[3], bp[3];
+    toom_split(a, an, s, ap, 3);
+    toom_split(b, bn, s, bp, 3);
+
+    bigint a1 = ap[0] + ap[2];
+    bigint am1 = a1 - ap[1];
+    a1 += ap[1];
+    bigint am2 = ((am1 + ap[2]) << 1) - ap[0];
+    bigint b1 = bp[0] + bp[2];
+    bigint bm1 = b1 - bp[1];
+    b1 += bp[1];
+    bigint bm2 = ((bm1 + bp[2]) << 1) - bp[0];
+
+    bigint w[5];
+    bigint v1, vm1, vm2;
+    bigint* const products[5] = {&w[0], &v1, &vm1, &vm2, &w[4]};
+    const bigint* const x[5] = {&ap[0], &a1, &am1, &am2, &ap[2]};
+    const bigint* const y[5] = {&bp[0], &b1, &bm1, &bm2, &bp[2]};
+    multiply_all(products, x, y, 5, bn);
+
+    w[3] = vm2 - v1;
+    w[3].div_limb(3);
+    w[1] = (v1 - vm1) >> 1;
+    w[2] = vm1 - w[0];
+    w[3] = (w[2] - w[3]) >> 1;
+    w[3] += w[4];
+    w[3] += w[4];
+    w[2] += w[1];
+    w[2] -= w[4];
+    w[1] -= w[3];
+
+    toom_recompose(r, an + bn, s, w, 5);
+}
+
+void bigint::mul_toom4(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    // Split into quarters and evaluate at 0, 1, -1, 2, -2, 1/2 (scaled by 8) and
+    // infinity. The even and odd halves of the product polynomial are separated
+    // using the symmetric points, which leaves two small systems to solve.
+    const size_t s = (an + 3) / 4;
+    bigint ap[4], bp[4];
+    toom_split(a, an, s, ap, 4);
+    toom_split(b, bn, s, bp, 4);
+
+    auto evaluate = [](const bigint* p, bigint* e) {
+        bigint even = p[0] + p[2];
+        bigint odd = p[1] + p[3];
+        e[0] = even + odd;
+        e[1] = even - odd;
+        even = p[0] + (p[2] << 2);
+        odd = (p[1] << 1) + (p[3] << 3);
+        e[2] = even + odd;
+        e[3] = even - odd;
+        e[4] = (((((p[0] << 1) + p[1]) << 1) + p[2]) << 1) + p[3];
+    };
+    bigint ea[5], eb[5];
+    evaluate(ap, ea);
+    evaluate(bp, eb);
+
+    bigint v[5];
+    bigint c[7];
+    bigint* const products[7] = {&v[0], &v[1], &v[2], &v[3], &v[4], &c[0], &c[6]};
+    const bigint* const x[7] = {&ea[0], &ea[1], &ea[2], &ea[3], &ea[4], &ap[0], &ap[3]};
+    const bigint* const y[7] = {&eb[0], &eb[1], &eb[2], &eb[3], &eb[4], &bp[0], &bp[3]};
+    multiply_all(products, x, y, 7, bn);
+
+    // Even coefficients from v(1) + v(-1) and v(2) + v(-2).
+    bigint e1 = ((v[0] + v[1]) >> 1) - c[0] - c[6];
+    bigint e2 = ((v[2] + v[3]) >> 1) - c[0] - (c[6] << 6);
+    c[4] = e2 - (e1 << 2);
+    c[4].div_limb(12);
+    c[2] = e1 - c[4];
+
+    // Odd coefficients from v(1) - v(-1), v(2) - v(-2) and v(1/2).
+    const bigint o1 = (v[0] - v[1]) >> 1;
+    const bigint o2 = (v[2] - v[3]) >> 2;
+    const bigint o3 = (v[4] - (c[0] << 6) - (c[2] << 4) - (c[4] << 2) - c[6]) >> 1;
+    bigint p = o2 - o1;
+    p.div_limb(3);
+    bigint q = (o1 << 4) - o3;
+    q.div_limb(3);
+    c[3] = q - p;
+    c[3].div_limb(3);
+    c[5] = p - c[3];
+    c[5].div_limb(5);
+    c[1] = o1 - c[3] - c[5];
+
+    toom_recompose(r, an + bn, s, c, 7);
+}
+
+void bigint::toom_split(const limb* src, size_t n, size_t s, bigint* pieces, size_t k) {
+    for (size_t i = 0; i < k && i * s < n; i++) {
+        pieces[i] = from_limbs(src + i * s, (n - i * s < s) ? n - i * s : s);
+    }
+}
+
+void bigint::toom_recompose(limb* r, size_t n, size_t s, const bigint* coeffs, size_t k) {
+    for (size_t i = 0; i < n; i++) {
+        r[i] = 0;
+    }
+    for (size_t i = 0; i < k; i++) {
+        const size_t cn = coeffs[i].num_limbs();
+        if (cn) add(r + i * s, r + i * s, n - i * s, coeffs[i].array, cn);
+    }
+}
+
+// MARK: Number-Theoretic Transform
+
+namespace {
+    // Arithmetic modulo an odd p < 2^62 in Montgomery form, with R = 2^64.
+    struct montgomery {
+        limb p;
+        limb p_neg_inv;
+        limb r2;
+
+        explicit montgomery(limb modulus) : p(modulus) {
+            limb inv = p;
+            for (int i = 0; i < 5; i++) inv *= 2 - p * inv;
+            p_neg_inv = -inv;
+            const limb r = -p % p;
+            r2 = static_cast<limb>(static_cast<dlimb>(r) * r % p);
+        }
+
+        // t * R^-1 mod p, for any t < 2^64 * p.
+        limb reduce(dlimb t) const {
+            const limb m = static_cast<limb>(t) * p_neg_inv;
+            const limb u = static_cast<limb>((t + static_cast<dlimb>(m) * p) >> 64);
+            return (u >= p) ? u - p : u;
+        }
+
+        limb mul(limb a, limb b) const { return reduce(static_cast<dlimb>(a) * b); }
+        limb add(limb a, limb b) const { return (a + b >= p) ? a + b - p : a + b; }
+        limb sub(limb a, limb b) const { return (a >= b) ? a - b : a + p - b; }
+        limb to(limb a) const { return mul(a, r2); }
+
+        limb pow(limb a, limb e) const {
+            limb result = to(1);
+            for (; e; e >>= 1) {
+                if (e & 0x1) result = mul(result, a);
+                a = mul(a, a);
+            }
+            return result;
+        }
+    };
+
+    // Primes of the form c * 2^k + 1 just below 2^62, with a primitive root of
+    // each. Their product exceeds n * 2^128 for any transform length n <= 2^53, so
+    // convolutions of 64-bit limbs can be recovered exactly by the CRT.
+    struct ntt_prime {
+        limb p;
+        limb g;
+    };
+    constexpr ntt_prime ntt_primes[3] = {
+        {0x3a00000000000001, 3},
+        {0x3ea0000000000001, 7},
+        {0x3ae0000000000001, 11}
+    };
+
+    // Fills roots[h + j] with w^j for each power of two h < n, where w is a
+    // primitive (2h)-th root of unity, or its inverse if inverse is set.
+    void ntt_roots(limb* roots, size_t n, const montgomery& m, limb g, bool inverse) {
+        limb w = m.pow(m.to(g), (m.p - 1) / n);
+        if (inverse) w = m.pow(w, m.p - 2);
+        const size_t h = n / 2;
+        roots[h] = m.to(1);
+        for (size_t j = 1; j < h; j++) {
+            roots[h + j] = m.mul(roots[h + j - 1], w);
+        }
+        for (size_t i = h / 2; i > 0; i /= 2) {
+            for (size_t j = 0; j < i; j++) {
+                roots[i + j] = roots[2 * (i + j)];
+            }
+        }
+    }
+
+    // Transforms split recursively until they are this many points, 128 KiB,
+    // so every stage below the split runs within the cache (or, for mapped
+    // numbers, within resident pages) instead of sweeping the whole array. The
+    // split stages are also the ones cut into tasks when threaded.
+    constexpr size_t ntt_block = 1 << 14;
+
+    // Decimation in frequency, leaving the result in bit-reversed order. Above
+    // ntt_block, the first stage runs over the whole array and the two
+    // half-size transforms that follow it run depth-first, as separate tasks
+    // in parallel.
+    void ntt_forward(limb* a, size_t n, const limb* roots, const montgomery& m, bool threaded) {
+        if (n > ntt_block) {
+            const size_t h = n / 2;
+            auto stage = [=, &m](size_t lo) {
+                for (size_t j = lo; j < lo + ntt_block; j++) {
+                    const limb u = a[j];
+                    const limb v = a[j + h];
+                    a[j] = m.add(u, v);
+                    a[j + h] = m.mul(m.sub(u, v), roots[h + j]);
+                }
+            };
+            if (!threaded) {
+                for (size_t lo = 0; lo < h; lo += ntt_block) stage(lo);
+                ntt_forward(a, h, roots, m, false);
+                ntt_forward(a + h, h, roots, m, false);
+                return;
+            }
+            task_group group;
+            for (size_t lo = 0; lo < h; lo += ntt_block) {
+                group.run([=] {stage(lo);});
+            }
+            group.wait();
+            group.run([=, &m] {ntt_forward(a, h, roots, m, true);});
+            ntt_forward(a + h, h, roots, m, true);
+            group.wait();
+            return;
+        }
+
+        for (size_t h = n / 2; h > 0; h /= 2) {
+            for (size_t i = 0; i < n; i += 2 * h) {
+                for (size_t j = 0; j < h; j++) {
+                    const limb u = a[i + j];
+                    const limb v = a[i + j + h];
+                    a[i + j] = m.add(u, v);
+                    a[i + j + h] = m.mul(m.sub(u, v), roots[h + j]);
+                }
+            }
+        }
+    }
+
+    // Decimation in time from bit-reversed order, without the 1/n scaling.
+    // Mirrors ntt_forward.
+    void ntt_inverse(limb* a, size_t n, const limb* roots, const montgomery& m, bool threaded) {
+        if (n > ntt_block) {
+            const size_t h = n / 2;
+            auto stage = [=, &m](size_t lo) {
+                for (size_t j = lo; j < lo + ntt_block; j++) {
+                    const limb u = a[j];
+                    const limb v = m.mul(a[j + h], roots[h + j]);
+                    a[j] = m.add(u, v);
+                    a[j + h] = m.sub(u, v);
+                }
+            };
+            if (!threaded) {
+                ntt_inverse(a, h, roots, m, false);
+                ntt_inverse(a + h, h, roots, m, false);
+                for (size_t lo = 0; lo < h; lo += ntt_block) stage(lo);
+                return;
+            }
+            task_group group;
+            group.run([=, &m] {ntt_inverse(a, h, roots, m, true);});
+            ntt_inverse(a + h, h, roots, m, true);
+            group.wait();
+            for (size_t lo = 0; lo < h; lo += ntt_block) {
+                group.run([=] {stage(lo);});
+            }
+            group.wait();
+            return;
+        }
+
+        for (size_t h = 1; h < n; h *= 2) {
+            for (size_t i = 0; i < n; i += 2 * h) {
+                for (size_t j = 0; j < h; j++) {
+                    const limb u = a[i + j];
+                    const limb v = m.mul(a[i + j + h], roots[h + j]);
+                    a[i + j] = m.add(u, v);
+                    a[i + j + h] = m.sub(u, v);
+                }
+            }
+        }
+    }
+
+    // Where large temporary buffers go. A mapped default resource keeps them out
+    // of core along with the numbers themselves; anything else, an arena in
+    // particular, would never get them back, so they go to the heap.
+    std::pmr::memory_resource* scratch_resource() {
+        std::pmr::memory_resource* mr = bigint::default_resource();
+        if (as_mapped(mr)) return mr;
+        return std::pmr::new_delete_resource();
+    }
+}
+
+void bigint::mul_ntt(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+    // Convolve the limbs modulo each prime, then recombine each coefficient with
+    // Garner's algorithm and propagate the carries.
+    size_t n = 1;
+    while (n < an + bn - 1) n *= 2;
+    if (n < 2) n = 2;
+    const bool square = a == b && an == bn;
+
+    // All buffers come from this thread, since the scratch resource need not be
+    // thread-safe. In parallel each prime gets its own roots and second operand.
+    const bool threaded = parallel(bn);
+    const size_t lanes = threaded ? 3 : 1;
+    std::pmr::memory_resource* mr = scratch_resource();
+    std::pmr::vector<limb> residues(3 * n, mr);
+    std::pmr::vector<limb> roots_buffer(lanes * n, mr);
+    std::pmr::vector<limb> other_buffer(square ? 0 : lanes * n, mr);
+    auto convolve = [&](size_t k) {
+        const montgomery m(ntt_primes[k].p);
+        limb* roots = roots_buffer.data() + (threaded ? k : 0) * n;
+        limb* fa = residues.data() + k * n;
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = (i < an) ? m.to(a[i]) : 0;
+        }
+        ntt_roots(roots, n, m, ntt_primes[k].g, false);
+        ntt_forward(fa, n, roots, m, threaded);
+        if (square) {
+            for (size_t i = 0; i < n; i++) {
+                fa[i] = m.mul(fa[i], fa[i]);
+            }
+        } else {
+            limb* fb = other_buffer.data() + (threaded ? k : 0) * n;
+            for (size_t i = 0; i < n; i++) {
+                fb[i] = (i < bn) ? m.to(b[i]) : 0;
+            }
+            ntt_forward(fb, n, roots, m, threaded);
+            for (size_t i = 0; i < n; i++) {
+                fa[i] = m.mul(fa[i], fb[i]);
+            }
+        }
+        ntt_roots(roots, n, m, ntt_primes[k].g, true);
+        ntt_inverse(fa, n, roots, m, threaded);
+
+        // Multiplying by the plain 1/n also leaves Montgomery form.
+        const limb n_inv = m.reduce(m.pow(m.to(n), m.p - 2));
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = m.mul(fa[i], n_inv);
+        }
+    };
+    if (threaded) {
+        task_group group;
+        group.run([&] {convolve(1);});
+        group.run([&] {convolve(2);});
+        convolve(0);
+        group.wait();
+    } else {
+        for (size_t k = 0; k < 3; k++) {
+            convolve(k);
+        }
+    }
+
+    const limb p1 = ntt_primes[0].p;
+    const limb p2 = ntt_primes[1].p;
+    const limb p3 = ntt_primes[2].p;
+    const montgomery m2(p2), m3(p3);
+    const limb inv12 = m2.pow(m2.to(p1), p2 - 2);
+    const limb inv13 = m3.pow(m3.to(p1), p3 - 2);
+    const limb inv23 = m3.pow(m3.to(p2 - p3), p3 - 2);
+
+    limb c0 = 0, c1 = 0, c2 = 0;
+    for (size_t i = 0; i < an + bn; i++) {
+        if (i < an + bn - 1) {
+            // x = v1 + p1 * (v2 + p2 * v3), with each vi reduced modulo pi.
+            const limb v1 = residues[i];
+            const limb v2 = m2.mul(m2.sub(residues[n + i], v1), inv12);
+            const limb v1_3 = (v1 >= p3) ? v1 - p3 : v1;
+            const limb v2_3 = (v2 >= p3) ? v2 - p3 : v2;
+            const limb v3 = m3.mul(m3.sub(m3.mul(m3.sub(residues[2 * n + i], v1_3), inv13), v2_3), inv23);
+            const dlimb t = static_cast<dlimb>(p2) * v3 + v2;
+            const dlimb lo = static_cast<dlimb>(p1) * static_cast<limb>(t) + v1;
+            const dlimb hi = static_cast<dlimb>(p1) * static_cast<limb>(t >> 64) + static_cast<limb>(lo >> 64);
+
+            dlimb sum = static_cast<dlimb>(c0) + static_cast<limb>(lo);
+            c0 = static_cast<limb>(sum);
+            sum = (sum >> 64) + c1 + static_cast<limb>(hi);
+            c1 = static_cast<limb>(sum);
+            c2 += static_cast<limb>(sum >> 64) + static_cast<limb>(hi >> 64);
+        }
+        r[i] = c0;
+        c0 = c1;
+        c1 = c2;
+        c2 = 0;
+    }
+}
+
+// MARK: GCD Algorithms
+
+// The reductions below keep the pair (a, b) unordered and only ever subtract a
+// multiple of the smaller from the larger, so every step has determinant 1.
+// When m is not null, it is multiplied on the right by the inverse of each
+// step, which keeps (a0, b0) = m (a, b) for the original pair. With s > 0, a
+// step is only taken if both numbers stay above 2^s; s = 0 allows any step.
+
+namespace {
+    // The 64 bits of x starting at bit k.
+    limb bits_at(const limb* x, size_t n, size_t k) {
+        const size_t i = k / 64;
+        const unsigned int shift = k % 64;
+        if (i >= n) return 0;
+        limb r = x[i] >> shift;
+        if (shift && i + 1 < n) r |= x[i + 1] << (64 - shift);
+        return r;
+    }
+
+    // Holds the products of a Lehmer step before they are copied back.
+    thread_local bigint gcd_scratch(std::pmr::new_delete_resource());
+
+    size_t bits(const limb* x, size_t n) {
+        while (n && !x[n - 1]) --n;
+        return n ? 64 * n - __builtin_clzll(x[n - 1]) : 0;
+    }
+
+    void matrix_mul(bigint* m, const bigint* n) {
+        for (size_t r = 0; r < 2; r++) {
+            const bigint m0 = m[2 * r];
+            bigint c0 = m0 * n[0];
+            bigint::addmul(c0, m[2 * r + 1], n[2]);
+            m[2 * r + 1] *= n[3];
+            bigint::addmul(m[2 * r + 1], m0, n[1]);
+            m[2 * r] = std::move(c0);
+        }
+    }
+}
+
+bool bigint::gcd_step(bigint& a, bigint& b, size_t s, bigint* m) {
+    // One Euclidean division of the larger number by the smaller.
+    const bool a_larger = a >= b;
+    bigint& x = a_larger ? a : b;
+    const bigint& y = a_larger ? b : a;
+    if (!y.num_limbs()) return false;
+    bigint q, r;
+    divide(x, y, &q, &r);
+    if (s && r.bit_length() <= s) return false;
+    x = std::move(r);
+    if (m) {
+        const size_t i = a_larger ? 0 : 1;
+        addmul(m[1 - i], m[i], q);
+        addmul(m[3 - i], m[2 + i], q);
+    }
+    return true;
+}
+
+bool bigint::lehmer_step(bigint& a, bigint& b, size_t s, bigint* m) {
+    // Knuth's Algorithm L: runs Euclid on the top 63 bits of both numbers for
+    // as long as the quotients are certain to match the full ones, then applies
+    // the accumulated cofactors to the full numbers in one pass.
+    const bool a_larger = a >= b;
+    bigint& x = a_larger ? a : b;
+    bigint& y = a_larger ? b : a;
+    const size_t n = x.num_limbs();
+    if (!y.num_limbs()) return false;
+    const size_t xbits = x.bit_length();
+    const size_t k = (xbits > 63) ? xbits - 63 : 0;
+    using sdlimb = __int128;
+    sdlimb u = bits_at(x.array, n, k);
+    sdlimb v = bits_at(y.array, y.num_limbs(), k);
+    sdlimb A = 1, B = 0, C = 0, D = 1;
+    bool odd = false;
+    while (v + C != 0 && v + D != 0) {
+        const sdlimb q = (u + A) / (v + C);
+        if (q != (u + B) / (v + D)) break;
+        sdlimb t = A - q * C;
+        A = C;
+        C = t;
+        t = B - q * D;
+        B = D;
+        D = t;
+        t = u - q * v;
+        u = v;
+        v = t;
+        odd = !odd;
+    }
+    if (B == 0) return gcd_step(a, b, s, m);
+
+    // After an odd number of steps the rows are swapped to keep determinant 1.
+    // Each row then has one entry <= 0 and the other >= 0.
+    if (odd) {
+        std::swap(A, C);
+        std::swap(B, D);
+    }
+    bigint& t = gcd_scratch;
+    t.reserve(2 * n);
+    limb* r0 = t.array;
+    limb* r1 = t.array + n;
+    y.reserve(n);
+    auto combine = [&](limb* r, sdlimb p, sdlimb q) {
+        if (q <= 0) {
+            mul_1(r, x.array, n, static_cast<limb>(p));
+            submul_1(r, y.array, n, static_cast<limb>(-q));
+        } else {
+            mul_1(r, y.array, n, static_cast<limb>(q));
+            submul_1(r, x.array, n, static_cast<limb>(-p));
+        }
+    };
+    combine(r0, A, B);
+    combine(r1, C, D);
+    if (s && (bits(r0, n) <= s || bits(r1, n) <= s)) return gcd_step(a, b, s, m);
+    for (size_t i = 0; i < n; i++) {
+        x.array[i] = r0[i];
+        y.array[i] = r1[i];
+    }
+    x.normalize(n);
+    y.normalize(n);
+    if (!m) return true;
+
+    // m times the inverse of [[A, B], [C, D]], with the inverse's rows and
+    // columns in (a, b) order. Its entries are non-negative.
+    limb inv[4] = {static_cast<limb>(D), static_cast<limb>(-B), static_cast<limb>(-C), static_cast<limb>(A)};
+    if (!a_larger) {
+        std::swap(inv[0], inv[3]);
+        std::swap(inv[1], inv[2]);
+    }
+    for (size_t r = 0; r < 2; r++) {
+        bigint& m0 = m[2 * r];
+        bigint& m1 = m[2 * r + 1];
+        const size_t len = std::max(m0.num_limbs(), m1.num_limbs());
+        m0.reserve(len + 1);
+        m1.reserve(len + 1);
+        t.reserve(2 * (len + 1));
+        limb* c0 = t.array;
+        limb* c1 = t.array + len + 1;
+        c0[len] = mul_1(c0, m0.array, len, inv[0]);
+        c0[len] += addmul_1(c0, m1.array, len, inv[2]);
+        c1[len] = mul_1(c1, m0.array, len, inv[1]);
+        c1[len] += addmul_1(c1, m1.array, len, inv[3]);
+        for (size_t i = 0; i <= len; i++) {
+            m0.array[i] = c0[i];
+            m1.array[i] = c1[i];
+        }
+        m0.normalize(len + 1);
+        m1.normalize(len + 1);
+    }
+    return true;
+}
+
+bool bigint::hgcd(bigint& a, bigint& b, size_t s, bigint* m) {
+    // The half-gcd: for a and b of at most n bits and s >= n / 2, reduces both
+    // to about s bits in O(M(n) log n). Two recursive calls each work on the top
+    // half of the current numbers, with a guard chosen so that their matrices,
+    // applied to the full numbers, still leave both above 2^s. Ordinary steps
+    // between and after them finish the reduction.
+    const size_t abits = a.bit_length();
+    const size_t bbits = b.bit_length();
+    if (abits <= s || bbits <= s) return false;
+    const size_t n = (abits > bbits) ? abits : bbits;
+
+    bool progress = false;
+    if (n / 64 < tuning.hgcd_threshold) {
+        while (lehmer_step(a, b, s, m)) progress = true;
+        return progress;
+    }
+
+    auto recurse = [&](size_t p, size_t inner_s) {
+        bigint a0 = a >> p;
+        bigint b0 = b >> p;
+        bigint sub[4] = {1, 0, 0, 1};
+        if (!hgcd(a0, b0, inner_s, sub)) return;
+        // (a, b) = sub (a', b') with det(sub) = 1.
+        bigint na = sub[3] * a;
+        submul(na, sub[1], b);
+        bigint nb = sub[0] * b;
+        submul(nb, sub[2], a);
+        if (na.is_negative || nb.is_negative || na.bit_length() <= s || nb.bit_length() <= s) return;
+        a = std::move(na);
+        b = std::move(nb);
+        if (m) matrix_mul(m, sub);
+        progress = true;
+    };
+
+    // Both recursive calls work on at most about n / 2 bits, so the recursion
+    // always shrinks. The second only runs once the steps between have brought
+    // the numbers to 3n/4 bits; if the guard stopped them first (say when a and
+    // b are close), the final steps below are all that can still be taken, and
+    // the caller falls back to an unguarded step.
+    recurse(s, (n - s) / 2 + 2);
+    size_t cur = std::max(a.bit_length(), b.bit_length());
+    while (cur > (3 * n) / 4 && lehmer_step(a, b, s, m)) {
+        progress = true;
+        cur = std::max(a.bit_length(), b.bit_length());
+    }
+    if (cur > s + 64 && cur <= (3 * n) / 4) {
+        recurse(2 * s - cur, cur - s + 1);
+    }
+    while (lehmer_step(a, b, s, m)) progress = true;
+    return progress;
+}
+
+void bigint::gcd_reduce(bigint& a, bigint& b, bigint* m) {
+    // Runs (a, b) down to (g, 0) or (0, g).
+    while (a.num_limbs() && b.num_limbs()) {
+        const size_t n = std::max(a.num_limbs(), b.num_limbs());
+        if (n >= tuning.hgcd_threshold) {
+            hgcd(a, b, std::max(a.bit_length(), b.bit_length()) / 2 + 1, m);
+            gcd_step(a, b, 0, m);
+        } else if (n > 1 || m) {
+            lehmer_step(a, b, 0, m);
+        } else {
+            // Binary gcd on single limbs.
+            limb x = a.array[0], y = b.array[0];
+            const int shift = __builtin_ctzll(x | y);
+            x >>= __builtin_ctzll(x);
+            while (y) {
+                y >>= __builtin_ctzll(y);
+                if (x > y) std::swap(x, y);
+                y -= x;
+            }
+            a = bigint(x << shift);
+            b = zero;
+        }
+    }
+}
+
+// MARK: Constructors
+
+bigint::bigint()
+    :capacity(0), limb_count(0), array(local), is_negative(false), resource(default_resource()) {}
+
+bigint::bigint(std::pmr::memory_resource* mr)
+    :capacity(0), limb_count(0), array(local), is_negative(false), resource(mr) {}
+
+bigint::bigint(char num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(short num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(int num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(long num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(long long num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(signed char num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(num < 0), resource(default_resource()) {
+    local[0] = is_negative ? -static_cast<limb>(num) : static_cast<limb>(num);
+}
+
+bigint::bigint(unsigned char num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(false), resource(default_resource()) {
+    local[0] = num;
+}
+
+bigint::bigint(unsigned short num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(false), resource(default_resource()) {
+    local[0] = num;
+}
+
+bigint::bigint(unsigned int num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(false), resource(default_resource()) {
+    local[0] = num;
+}
+
+bigint::bigint(unsigned long num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(false), resource(default_resource()) {
+    local[0] = num;
+}
+
+bigint::bigint(unsigned long long num)
+    :capacity(1), limb_count(num != 0), array(local), is_negative(false), resource(default_resource()) {
+    local[0] = num;
+}
+
+// MARK: Rule of 5
+
+bigint::bigint(const bigint& other)
+    :bigint(other, default_resource()) {}
+
+bigint::bigint(const bigint& other, std::pmr::memory_resource* mr)
+    :capacity(other.limb_count), limb_count(other.limb_count), array(local), is_negative(other.is_negative), resource(mr) {
+    // Only the limbs in use are copied; the source's spare capacity is not.
+    if (capacity > inline_limbs) array = allocate(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        array[i] = other.array[i];
+    }
+}
+
+bigint::bigint(bigint&& other) noexcept
+    :capacity(other.capacity), limb_count(other.limb_count), array(other.array == other.local ? local : other.array), is_negative(other.is_negative), resource(other.resource) {
+    if (array == local) {
+        for (size_t i = 0; i < capacity; i++) {
+            local[i] = other.local[i];
+        }
+    }
+    other.capacity = 0;
+    other.limb_count = 0;
+    other.array = other.local;
+    other.is_negative = false;
+}
+
+bigint::~bigint() {
+    if (array != local) deallocate(array, capacity);
+}
+
+bigint& bigint::operator = (const bigint& other) {
+    if (&other == this) return *this;
+
+    // Keep the current buffer if the value fits in it. Limbs past the old
+    // count are already zero, so only those between the two counts are cleared.
+    const size_t n = other.num_limbs();
+    if (capacity < n) {
+        if (array != local) deallocate(array, capacity);
+        capacity = n;
+        array = (capacity > inline_limbs) ? allocate(capacity) : local;
+        limb_count = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        array[i] = other.array[i];
+    }
+    for (size_t i = n; i < limb_count; i++) {
+        array[i] = 0;
+    }
+    limb_count = n;
+    is_negative = other.is_negative;
+
+    return *this;
+}
+
+bigint& bigint::operator = (bigint&& other) {
+    if (&other == this) return *this;
+    // Like the std::pmr containers, storage only moves between objects that
+    // share a memory resource.
+    if (*resource != *other.resource) return *this = static_cast<const bigint&>(other);
+
+    if (array != local) deallocate(array, capacity);
+    capacity = other.capacity;
+    if (other.array == other.local) {
+        array = local;
+        for (size_t i = 0; i < capacity; i++) {
+            local[i] = other.local[i];
+        }
+    } else array = other.array;
+    limb_count = other.limb_count;
+    is_negative = other.is_negative;
+
+    other.capacity = 0;
+    other.limb_count = 0;
+    other.array = other.local;
+    other.is_negative = false;
+
+    return *this;
+}
+
+// MARK: Conversion Operators
+
+bigint::operator bool() const {
+    return limb_count != 0;
+}
+
+bigint::operator char() const {
+    if (std::numeric_limits<char>().min() == 0) return this->operator unsigned char();
+    else return this->operator signed char();
+}
+
+bigint::operator short() const {
+    using T = short;
+    using U = unsigned short;
+
+    U result_u = is_negative ? -*this : *this;
+    if (is_negative) --result_u;
+    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
+    T result = result_u;
+    if (is_negative) result = -result - 1;
+    return result;
+}
+
+bigint::operator int() const {
+    using T = int;
+    using U = unsigned int;
+
+    U result_u = is_negative ? -*this : *this;
+    if (is_negative) --result_u;
+    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
+    T result = result_u;
+    if (is_negative) result = -result - 1;
+    return result;
+}
+
+bigint::operator long() const {
+    using T = long;
+    using U = unsigned long;
+
+    U result_u = is_negative ? -*this : *this;
+    if (is_negative) --result_u;
+    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
+    T result = result_u;
+    if (is_negative) result = -result - 1;
+    return result;
+}
+
+bigint::operator long long() const {
+    using T = long long;
+    using U = unsigned long long;
+
+    U result_u = is_negative ? -*this : *this;
+    if (is_negative) --result_u;
+    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
+    T result = result_u;
+    if (is_negative) result = -result - 1;
+    return result;
+}
+
+bigint::operator signed char() const {
+    using T = signed char;
+    using U = unsigned char;
+
+    U result_u = is_negative ? -*this : *this;
+    if (is_negative) --result_u;
+    if (result_u > std::numeric_limits<U>().max() / 2) throw std::overflow_error("Conversion to signed type failed: bigint is too large.");
+    T result = result_u;
+    if (is_negative) result = -result - 1;
+    return result;
+}
+
+bigint::operator unsigned char() const {
+    using T = unsigned char;
+
+    T result = 0;
+    size_t i = num_limbs();
+    if (is_negative) {
+        if (i) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    } else {
+        if (i > 1 || (i && array[0] > std::numeric_limits<T>().max())) throw std::overflow_error("Conversion failed: bigint is too large");
+        if (i) result = array[0];
+    }
+    return result;
+}
+
+bigint::operator unsigned short() const {
+    using T = unsigned short;
+
+    T result = 0;
+    size_t i = num_limbs();
+    if (is_negative) {
+        if (i) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    } else {
+        if (i > 1 || (i && array[0] > std::numeric_limits<T>().max())) throw std::overflow_error("Conversion failed: bigint is too large");
+        if (i) result = array[0];
+    }
+    return result;
+}
+
+bigint::operator unsigned int() const {
+    using T = unsigned int;
+
+    T result = 0;
+    size_t i = num_limbs();
+    if (is_negative) {
+        if (i) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    } else {
+        if (i > 1 || (i && array[0] > std::numeric_limits<T>().max())) throw std::overflow_error("Conversion failed: bigint is too large");
+        if (i) result = array[0];
+    }
+    return result;
+}
+
+bigint::operator unsigned long() const {
+    using T = unsigned long;
+
+    T result = 0;
+    size_t i = num_limbs();
+    if (is_negative) {
+        if (i) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    } else {
+        if (i > 1 || (i && array[0] > std::numeric_limits<T>().max())) throw std::overflow_error("Conversion failed: bigint is too large");
+        if (i) result = array[0];
+    }
+    return result;
+}
+
+bigint::operator unsigned long long() const {
+    using T = unsigned long long;
+
+    T result = 0;
+    size_t i = num_limbs();
+    if (is_negative) {
+        if (i) throw std::overflow_error("Conversion to unsigned type failed: bigint is negative.");
+    } else {
+        if (i > 1 || (i && array[0] > std::numeric_limits<T>().max())) throw std::overflow_error("Conversion failed: bigint is too large");
+        if (i) result = array[0];
+    }
+    return result;
+}
+
+// MARK: Unary Operators
+
+bigint bigint::operator + () const {
+    bigint result = *this;
+    return result;
+}
+
+bigint bigint::operator - () const {
+    bigint result = *this;
+    result.is_negative = !result.is_negative && result.num_limbs();
+    return result;
+}
+
+bigint& bigint::operator ++ () {
+    if (is_negative) {
+        is_negative = false;
+        this->operator--();
+        is_negative = limb_count != 0;
+        return *this;
+    }
+
+    size_t i = 0;
+    do {
+        if (i == capacity) grow();
+        ++array[i];
+    } while (!array[i++]);
+    if (i > limb_count) limb_count = i;
+
+    return *this;
+}
+
+bigint& bigint::operator -- () {
+    if (is_negative) {
+        is_negative = !is_negative;
+        this->operator++();
+        is_negative = !is_negative;
+        return *this;
+    }
+
+    size_t i = 0;
+    if (!capacity) grow();
+    while (i < capacity) {
+        if (array[i]) break;
+        ++i;
+    }
+    if (i < capacity) {
+        do {
+            --array[i];
+        } while (i-- > 0);
+    } else {
+        array[0] = 0x01;
+        is_negative = true;
+    }
+    normalize(limb_count ? limb_count : 1);
+
+    return *this;
+}
+
+bigint bigint::operator ++ (int) {
+    bigint result = *this;
+    this->operator++();
+    return result;
+}
+
+bigint bigint::operator -- (int) {
+    bigint result = *this;
+    this->operator--();
+    return result;
+}
+
+// MARK: Relational Operators
+
+int bigint::compare(const bigint& rhs) const {
+    // Zero is never negative, so differing signs decide at once; otherwise the
+    // lengths do, and only equal lengths need the limbs.
+    if (is_negative != rhs.is_negative) return is_negative ? -1 : 1;
+    const int c = cmp(array, limb_count, rhs.array, rhs.limb_count);
+    return is_negative ? -c : c;
+}
+
+int bigint::compare_abs(const bigint& rhs) const {
+    return cmp(array, limb_count, rhs.array, rhs.limb_count);
+}
+
+bool bigint::operator == (const bigint& rhs) const {
+    if (limb_count != rhs.limb_count || is_negative != rhs.is_negative) return false;
+    for (size_t i = limb_count; i-- > 0; ) {
+        if (array[i] != rhs.array[i]) return false;
+    }
+    return true;
+}
+
+bool bigint::operator != (const bigint& rhs) const {
+    return !this->operator==(rhs);
+}
+
+bool bigint::operator < (const bigint& rhs) const {
+    return compare(rhs) < 0;
+}
+
+bool bigint::operator > (const bigint& rhs) const {
+    return compare(rhs) > 0;
+}
+
+bool bigint::operator <= (const bigint& rhs) const {
+    return compare(rhs) <= 0;
+}
+
+bool bigint::operator >= (const bigint& rhs) const {
+    return compare(rhs) >= 0;
+}
+
+// MARK: Binary Arithmetic Operators
+
+bigint bigint::operator + (const bigint& rhs) const {
+    bigint result;
+    signed_add(result, *this, is_negative, rhs, rhs.is_negative);
+    return result;
+}
+
+bigint bigint::operator - (const bigint& rhs) const {
+    bigint result;
+    signed_add(result, *this, is_negative, rhs, !rhs.is_negative);
+    return result;
+}
+
+bigint bigint::operator * (const bigint& rhs) const {
+    bigint result;
+    multiply_into(result, *this, rhs);
+    return result;
+}
+
+bigint bigint::operator / (const bigint& rhs) const {
+    bigint result;
+    divide(*this, rhs, &result, nullptr);
+    return result;
 }
 
-bigint bigint::operator - () const {
-    bigint result = *this;
-    result.is_negative = !result.is_negative;
+bigint bigint::operator % (const bigint& rhs) const {
+    bigint result;
+    divide(*this, rhs, nullptr, &result);
     return result;
 }
 
-bigint& bigint::operator ++ () {
-    if (is_negative) {
-        is_negative = !is_negative;
-        this->operator--();
-        is_negative = !is_negative;
+// MARK: Arithmetic Assignment Operators
+
+bigint& bigint::operator += (const bigint& other) {
+    signed_add(*this, *this, is_negative, other, other.is_negative);
+    return *this;
+}
+
+bigint& bigint::operator -= (const bigint& other) {
+    signed_add(*this, *this, is_negative, other, !other.is_negative);
+    return *this;
+}
+
+bigint& bigint::operator *= (const bigint& other) {
+    const size_t n = num_limbs();
+    const size_t on = other.num_limbs();
+    if (!n) return *this;
+    if (on == 1) {
+        reserve(n + 1);
+        array[n] = mul_1(array, array, n, other.array[0]);
+        is_negative = is_negative != other.is_negative;
+        normalize(n + 1);
         return *this;
     }
 
-    size_t i = 0;
-    do {
-        if (i == capacity) grow();
-        ++array[i];
-    } while (!array[i++]);
+    // The product cannot overlap its operands, so build it in the scratch buffer
+    // and trade buffers with it, leaving this one to be reused next time.
+    multiply_into(product_scratch, *this, other);
+    if (*resource == *product_scratch.resource) {
+        std::swap(*this, product_scratch);
+    } else {
+        *this = product_scratch;
+    }
+    return *this;
+}
 
+bigint& bigint::operator /= (const bigint& other) {
+    const size_t n = num_limbs();
+    if (other.num_limbs() == 1) {
+        divrem_1(array, array, n, other.array[0]);
+        is_negative = is_negative != other.is_negative;
+        normalize(n);
+        return *this;
+    }
+    divide(*this, other, this, nullptr);
     return *this;
 }
 
-bigint& bigint::operator -- () {
-    if (is_negative) {
-        is_negative = !is_negative;
-        this->operator++();
-        is_negative = !is_negative;
+bigint& bigint::operator %= (const bigint& other) {
+    const size_t n = num_limbs();
+    if (other.num_limbs() == 1) {
+        const limb r = divrem_1(array, array, n, other.array[0]);
+        for (size_t i = 1; i < n; i++) {
+            array[i] = 0;
+        }
+        if (n) array[0] = r;
+        normalize(n ? 1 : 0);
         return *this;
     }
+    divide(*this, other, nullptr, this);
+    return *this;
+}
 
-    size_t i = 0;
-    if (!capacity) grow();
-    while (i < capacity) {
-        if (array[i]) break;
-        ++i;
+// MARK: Binary Bitwise Operators
+
+bigint bigint::operator & (const bigint& rhs) const {
+    const operation_scope scope(operation::bitwise);
+    const bigint& lhs = *this;
+
+    const size_t n = std::min(lhs.num_limbs(), rhs.num_limbs());
+    bigint result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        result.array[i] = lhs.array[i] & rhs.array[i];
     }
-    if (i < capacity) {
-        do {
-            --array[i];
-        } while (i-- > 0);
+    result.normalize(n);
+    return result;
+}
+
+bigint bigint::operator | (const bigint& rhs) const {
+    const operation_scope scope(operation::bitwise);
+    const bigint& lhs = *this;
+
+    const size_t ln = lhs.num_limbs(), rn = rhs.num_limbs();
+    const size_t n = std::max(ln, rn);
+    bigint result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        const limb llimb = (i < ln) ? lhs.array[i] : 0;
+        const limb rlimb = (i < rn) ? rhs.array[i] : 0;
+        result.array[i] = llimb | rlimb;
+    }
+    result.normalize(n);
+    return result;
+}
+
+bigint bigint::operator ^ (const bigint& rhs) const {
+    const operation_scope scope(operation::bitwise);
+    const bigint& lhs = *this;
+
+    const size_t ln = lhs.num_limbs(), rn = rhs.num_limbs();
+    const size_t n = std::max(ln, rn);
+    bigint result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        const limb llimb = (i < ln) ? lhs.array[i] : 0;
+        const limb rlimb = (i < rn) ? rhs.array[i] : 0;
+        result.array[i] = llimb ^ rlimb;
+    }
+    result.normalize(n);
+    return result;
+}
+
+bigint bigint::operator << (size_t rhs) const {
+    const operation_scope scope(operation::shift);
+    const size_t nb = num_limbs();
+    if (nb == 0) return zero;
+
+    const unsigned int shamt = rhs % 64;
+    const size_t offset = rhs / 64;
+    if (offset > std::numeric_limits<size_t>().max() / sizeof(limb) - nb - 1) throw std::overflow_error("Logical shift error: shift too large.");
+    const size_t n = nb + offset + ((shamt && (array[nb - 1] >> (64 - shamt))) ? 1 : 0);
+
+    // reserve() leaves the low offset limbs zero.
+    bigint result;
+    result.reserve(n);
+    if (shamt) {
+        const limb top = lshift(result.array + offset, array, nb, shamt);
+        if (top) result.array[nb + offset] = top;
     } else {
-        array[0] = 0x01;
-        is_negative = true;
+        std::memcpy(result.array + offset, array, nb * sizeof(limb));
+    }
+    result.limb_count = n;
+    result.is_negative = is_negative;
+    return result;
+}
+
+bigint bigint::operator >> (size_t rhs) const {
+    const operation_scope scope(operation::shift);
+    const size_t nb = num_limbs();
+    const unsigned int shamt = rhs % 64;
+    const size_t offset = rhs / 64;
+    if (offset >= nb) return zero;
+
+    const size_t n = nb - offset;
+    bigint result;
+    result.reserve(n);
+    if (shamt) rshift(result.array, array + offset, n, shamt);
+    else std::memcpy(result.array, array + offset, n * sizeof(limb));
+    result.is_negative = is_negative;
+    result.normalize(n);
+    return result;
+}
+
+// MARK: Bitwise Assignment Operators
+
+bigint& bigint::operator &= (const bigint& other) {
+    const operation_scope scope(operation::bitwise);
+    const size_t n = std::min(limb_count, other.num_limbs());
+    for (size_t i = 0; i < n; i++) {
+        array[i] &= other.array[i];
     }
+    for (size_t i = n; i < limb_count; i++) {
+        array[i] = 0;
+    }
+    normalize(n);
+    return *this;
+}
 
+bigint& bigint::operator |= (const bigint& other) {
+    const operation_scope scope(operation::bitwise);
+    const size_t rn = other.num_limbs();
+    const size_t n = std::max(limb_count, rn);
+    reserve(n);
+    for (size_t i = 0; i < rn; i++) {
+        array[i] |= other.array[i];
+    }
+    normalize(n);
     return *this;
 }
 
-bigint bigint::operator ++ (int) {
-    bigint result = *this;
-    this->operator++();
+bigint& bigint::operator ^= (const bigint& other) {
+    const operation_scope scope(operation::bitwise);
+    const size_t rn = other.num_limbs();
+    const size_t n = std::max(limb_count, rn);
+    reserve(n);
+    for (size_t i = 0; i < rn; i++) {
+        array[i] ^= other.array[i];
+    }
+    normalize(n);
+    return *this;
+}
+
+bigint& bigint::operator <<= (size_t other) {
+    const operation_scope scope(operation::shift);
+    const size_t nb = num_limbs();
+    if (nb == 0) return *this;
+
+    const unsigned int shamt = other % 64;
+    const size_t offset = other / 64;
+    if (offset > std::numeric_limits<size_t>().max() / sizeof(limb) - nb - 1) throw std::overflow_error("Logical shift error: shift too large.");
+    reserve(nb + offset + 1);
+
+    // Move the limbs up, shifting within them in the same pass, then clear the
+    // vacated ones. The limb above the old top is already zero.
+    if (shamt) array[nb + offset] = lshift(array + offset, array, nb, shamt);
+    else if (offset) std::memmove(array + offset, array, nb * sizeof(limb));
+    std::memset(array, 0, offset * sizeof(limb));
+    normalize(nb + offset + 1);
+    return *this;
+}
+
+bigint& bigint::operator >>= (size_t other) {
+    const operation_scope scope(operation::shift);
+    const size_t nb = num_limbs();
+    const unsigned int shamt = other % 64;
+    const size_t offset = other / 64;
+    const size_t n = (offset < nb) ? nb - offset : 0;
+
+    if (shamt && n) rshift(array, array + offset, n, shamt);
+    else if (offset && n) std::memmove(array, array + offset, n * sizeof(limb));
+    std::memset(array + n, 0, (nb - n) * sizeof(limb));
+    normalize(n);
+    return *this;
+}
+
+// MARK: std::string Conversion
+
+namespace {
+    // 10^(19 * 2^k) at index 2k and its reciprocal at index 2k + 1, extended as
+    // to_string needs larger powers.
+    thread_local std::vector<bigint> decimal_powers;
+}
+
+size_t bigint::decimal_level(size_t n) {
+    // The k for which n-limb numbers are split around 10^(19 * 2^k), extending
+    // the cache of powers as needed.
+    size_t k = 0;
+    if (n <= to_string_threshold) return k;
+    // The cache outlives whatever resource is current, so it keeps its own.
+    std::pmr::memory_resource* mr = std::pmr::new_delete_resource();
+    if (decimal_powers.empty()) {
+        decimal_powers.emplace_back(bigint(10000000000000000000ull), mr);
+        decimal_powers.emplace_back(newton_reciprocal(decimal_powers[0]), mr);
+    }
+    while (2 * decimal_powers[2 * k].num_limbs() - 2 < n) {
+        ++k;
+        if (decimal_powers.size() == 2 * k) {
+            bigint power(decimal_powers[2 * k - 2] * decimal_powers[2 * k - 2], mr);
+            bigint inverse(newton_reciprocal(power), mr);
+            decimal_powers.push_back(std::move(power));
+            decimal_powers.push_back(std::move(inverse));
+        }
+    }
+    return k;
+}
+
+void bigint::write_decimal(const digit_sink& sink) const {
+    // Numbers below x < 10^(19 * 2^(k+1)) are split around 10^(19 * 2^k) and each
+    // half converted recursively, so the work is dominated by a few large
+    // multiplications rather than a quadratic number of limb divisions. The
+    // halves are emitted most significant first as soon as they reach the
+    // base case.
+    const operation_scope scope(operation::convert);
+    const size_t n = num_limbs();
+    if constexpr (stats_enabled) count_size(convert_sizes_at, n);
+    if (is_negative && n) sink("-", 1);
+    to_decimal(sink, *this, decimal_level(n), false);
+}
+
+void bigint::write_decimal(std::ostream& os) const {
+    write_decimal([&os](const char* digits, size_t len) {os.write(digits, len);});
+}
+
+std::string bigint::to_string() const {
+    // 64 bits make at most 19.3 digits, so one reservation covers the result.
+    std::string result;
+    result.reserve(num_limbs() * 20 + 2);
+    write_decimal([&result](const char* digits, size_t len) {result.append(digits, len);});
     return result;
 }
 
-bigint bigint::operator -- (int) {
-    bigint result = *this;
-    this->operator--();
+void bigint::to_decimal(const digit_sink& sink, const bigint& x, size_t k, bool pad) {
+    // Emits the digits of |x| < 10^(19 * 2^(k+1)), zero-padded to exactly that
+    // many digits if pad is set.
+    const size_t n = x.num_limbs();
+    if (n <= to_string_threshold) {
+        // Peel off 19 decimal digits at a time by dividing by the largest power of
+        // 10 that fits in a limb, filling the buffer from the back.
+        char digits[to_string_threshold * 20];
+        char* p = digits + sizeof(digits);
+        limb cpy[to_string_threshold];
+        for (size_t i = 0; i < n; i++) {
+            cpy[i] = x.array[i];
+        }
+        size_t m = n;
+        while (m) {
+            limb rem = divrem_1(cpy, cpy, m, 10000000000000000000ull);
+            while (m > 0 && !cpy[m - 1]) --m;
+            for (int i = 0; i < 19 && (m || rem); i++) {
+                *--p = '0' + rem % 10;
+                rem /= 10;
+            }
+        }
+        const size_t len = digits + sizeof(digits) - p;
+        if (pad) {
+            static const std::string zeros(4096, '0');
+            for (size_t z = (static_cast<size_t>(19) << (k + 1)) - len; z; ) {
+                const size_t step = std::min(z, zeros.size());
+                sink(zeros.data(), step);
+                z -= step;
+            }
+        } else if (!len) {
+            *--p = '0';
+        }
+        sink(p, digits + sizeof(digits) - p);
+        return;
+    }
+
+    const bigint& power = decimal_powers[2 * k];
+    if (!pad && cmp(x.array, n, power.array, power.num_limbs()) < 0) {
+        to_decimal(sink, x, k - 1, false);
+        return;
+    }
+    bigint q, r;
+    divide_newton(x, power, decimal_powers[2 * k + 1], q, r);
+    to_decimal(sink, q, k - 1, pad);
+    to_decimal(sink, r, k - 1, true);
+}
+
+std::string bigint::to_hex(bool print_leading_zeros) const {
+    const operation_scope scope(operation::convert);
+    if constexpr (stats_enabled) count_size(convert_sizes_at, num_limbs());
+    std::string result = is_negative ? "-0x" : "0x";
+    const char hex_table[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    bool started = false;
+    for (size_t i = limb_count; i-- > 0; ) {
+        for (unsigned int j = 16; j-- > 0; ) {
+            const unsigned int nibble = (array[i] >> (j << 2)) & 0xF;
+            if (nibble) started = true;
+            if (started || print_leading_zeros) result.push_back(hex_table[nibble]);
+        }
+    }
+    if (result.back() == 'x') result.push_back('0');
+
     return result;
 }
 
-// MARK: Relational Operators
+std::string bigint::to_bin(bool print_leading_zeros) const {
+    const operation_scope scope(operation::convert);
+    if constexpr (stats_enabled) count_size(convert_sizes_at, num_limbs());
+    std::string result = is_negative ? "-" : "";
 
-bool bigint::operator == (const bigint& rhs) const {
-    const bigint& lhs = *this;
+    bool started = false;
+    for (size_t i = limb_count; i-- > 0; ) {
+        for (unsigned int j = 64; j-- > 0; ) {
+            bool is_on = (array[i] >> j) & 0x1;
+            if (is_on) started = true;
+            if (started || print_leading_zeros) result.push_back(is_on ? '1' : '0');
+        }
+    }
+
+    if (result.empty() || result.back() == '-') result.push_back('0');
+    return result;
+}
+
+bigint bigint::from_digits(const char* str, size_t n, int base) {
+    if (!(base & (base - 1))) {
+        // Power-of-two bases pack each digit's bits straight into the limbs,
+        // starting from the least significant digit.
+        const unsigned int bits = __builtin_ctz(base);
+        bigint result;
+        result.reserve((n * bits + 63) / 64);
+        size_t i = 0;
+        unsigned int shift = 0;
+        for (size_t j = n; j-- > 0; ) {
+            const limb digit = digit_value(str[j]);
+            result.array[i] |= digit << shift;
+            shift += bits;
+            if (shift >= 64) {
+                shift -= 64;
+                ++i;
+                if (shift) result.array[i] = digit >> (bits - shift);
+            }
+        }
+        result.trim();
+        return result;
+    }
+
+    // Each limb takes k digits at once, with big_base = base^k. Runs of
+    // from_digits_threshold limbs are parsed by multiply-and-add, then adjacent
+    // runs are combined pairwise, squaring the multiplier at each level.
+    limb big_base = base;
+    size_t k = 1;
+    while (big_base <= std::numeric_limits<limb>::max() / base) {
+        big_base *= base;
+        ++k;
+    }
+
+    auto parse = [&](const char* s, size_t len) {
+        bigint result;
+        result.reserve((len + k - 1) / k);
+        size_t used = 0;
+        size_t chunk = (len % k) ? len % k : k;
+        for (size_t i = 0; i < len; i += chunk, chunk = k) {
+            limb value = 0;
+            limb scale = 1;
+            for (size_t j = i; j < i + chunk; j++) {
+                value = value * base + digit_value(s[j]);
+                scale *= base;
+            }
+            dlimb acc = value;
+            for (size_t j = 0; j < used; j++) {
+                acc += static_cast<dlimb>(result.array[j]) * scale;
+                result.array[j] = static_cast<limb>(acc);
+                acc >>= 64;
+            }
+            if (acc) result.array[used++] = static_cast<limb>(acc);
+        }
+        result.trim();
+        return result;
+    };
+
+    const size_t run = k * from_digits_threshold;
+    if (n <= run) return parse(str, n);
+
+    std::vector<bigint> parts;
+    for (size_t end = n; end > 0; ) {
+        const size_t begin = (end > run) ? end - run : 0;
+        parts.push_back(parse(str + begin, end - begin));
+        end = begin;
+    }
+    bigint multiplier = pow(static_cast<bigint>(big_base), from_digits_threshold);
+    while (parts.size() > 1) {
+        for (size_t i = 0; i < parts.size(); i += 2) {
+            if (i + 1 < parts.size()) {
+                parts[i / 2] = parts[i + 1] * multiplier + parts[i];
+            } else {
+                parts[i / 2] = std::move(parts[i]);
+            }
+        }
+        parts.resize((parts.size() + 1) / 2);
+        if (parts.size() > 1) multiplier *= multiplier;
+    }
+    return std::move(parts[0]);
+}
+
+// MARK: Binary Conversion
+
+namespace {
+    constexpr bool little_endian_host = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+    // Where byte k of the magnitude goes among count words of size bytes.
+    struct byte_layout {
+        size_t count;
+        size_t size;
+        bool words_little;
+        bool bytes_little;
+
+        size_t offset(size_t k) const {
+            const size_t w = k / size;
+            const size_t b = k % size;
+            return (words_little ? w : count - 1 - w) * size + (bytes_little ? b : size - 1 - b);
+        }
+    };
+
+    byte_layout layout(size_t count, size_t size, bigint::endian word_order, bigint::endian byte_order) {
+        if (!size) throw std::invalid_argument("Word size must be positive.");
+        auto little = [](bigint::endian e) {return e == bigint::endian::little || (e == bigint::endian::native && little_endian_host);};
+        return {count, size, little(word_order), little(byte_order)};
+    }
+}
+
+bigint bigint::import_bytes(const void* data, size_t count, size_t word_size, endian word_order, endian byte_order) {
+    const operation_scope scope(operation::convert);
+    const byte_layout l = layout(count, word_size, word_order, byte_order);
+    const unsigned char* in = static_cast<const unsigned char*>(data);
+    const size_t bytes = count * word_size;
+    const size_t n = (bytes + 7) / 8;
+
+    bigint result;
+    result.reserve(n);
+    if (l.words_little && l.bytes_little && little_endian_host) {
+        // Little-endian throughout, which is the limbs' own layout.
+        std::memcpy(result.array, in, bytes);
+    } else if (!l.words_little && !l.bytes_little) {
+        // Big-endian throughout: the limbs in reverse, each byte-swapped.
+        for (size_t i = 0; i < bytes / 8; i++) {
+            limb x;
+            std::memcpy(&x, in + bytes - 8 * (i + 1), 8);
+            result.array[i] = little_endian_host ? __builtin_bswap64(x) : x;
+        }
+        for (size_t k = bytes / 8 * 8; k < bytes; k++) {
+            result.array[k / 8] |= static_cast<limb>(in[bytes - 1 - k]) << (8 * (k % 8));
+        }
+    } else {
+        for (size_t k = 0; k < bytes; k++) {
+            result.array[k / 8] |= static_cast<limb>(in[l.offset(k)]) << (8 * (k % 8));
+        }
+    }
+    result.trim();
+    if constexpr (stats_enabled) count_size(convert_sizes_at, result.num_limbs());
+    return result;
+}
+
+size_t bigint::export_size(size_t word_size) const {
+    if (!word_size) throw std::invalid_argument("Word size must be positive.");
+    return ((bit_length() + 7) / 8 + word_size - 1) / word_size;
+}
+
+size_t bigint::export_bytes(void* data, size_t count, size_t word_size, endian word_order, endian byte_order) const {
+    const operation_scope scope(operation::convert);
+    const size_t words = export_size(word_size);
+    if (count < words) throw std::length_error("Buffer too small for export.");
+    if constexpr (stats_enabled) count_size(convert_sizes_at, num_limbs());
+    const byte_layout l = layout(words, word_size, word_order, byte_order);
+    unsigned char* out = static_cast<unsigned char*>(data);
+    const size_t bytes = words * word_size;
+    const size_t used = std::min(bytes, 8 * num_limbs());
+
+    if (l.words_little && l.bytes_little && little_endian_host) {
+        std::memcpy(out, array, used);
+        std::memset(out + used, 0, bytes - used);
+    } else if (!l.words_little && !l.bytes_little) {
+        const size_t full = used / 8;
+        for (size_t i = 0; i < full; i++) {
+            const limb x = little_endian_host ? __builtin_bswap64(array[i]) : array[i];
+            std::memcpy(out + bytes - 8 * (i + 1), &x, 8);
+        }
+        for (size_t k = 8 * full; k < bytes; k++) {
+            out[bytes - 1 - k] = (k < used) ? static_cast<unsigned char>(array[k / 8] >> (8 * (k % 8))) : 0;
+        }
+    } else {
+        for (size_t k = 0; k < bytes; k++) {
+            out[l.offset(k)] = (k < used) ? static_cast<unsigned char>(array[k / 8] >> (8 * (k % 8))) : 0;
+        }
+    }
+    return words;
+}
+
+// MARK: Static Functions
+
+bigint bigint::pow(const bigint& base, const bigint& exp) {
+    const operation_scope scope(operation::power);
+    if (exp < 0) return zero;
+
+    bigint b = base;
+    bigint result = 1;
+    const size_t n = exp.num_limbs();
+    for (size_t i = 0; i < n; i++) {
+        limb word = exp.array[i];
+        for (int j = 0; j < 64; j++) {
+            if (word & 0x1) result *= b;
+            word >>= 1;
+            if (i + 1 == n && !word) break;
+            b *= b;
+        }
+    }
+    return result;
+}
+
+bigint bigint::powmod(const bigint& base, const bigint& exp, const bigint& mod) {
+    const operation_scope scope(operation::power);
+    const bigint_mod_context ctx(mod);
+    return ctx.pow(ctx(base), exp).value();
+}
+
+bigint bigint::gcd(const bigint& lhs, const bigint& rhs) {
+    const operation_scope scope(operation::gcd);
+    bigint a = from_limbs(lhs.array, lhs.num_limbs());
+    bigint b = from_limbs(rhs.array, rhs.num_limbs());
+    gcd_reduce(a, b, nullptr);
+    return a.num_limbs() ? a : b;
+}
+
+std::tuple<bigint, bigint, bigint> bigint::gcdext(const bigint& lhs, const bigint& rhs) {
+    const operation_scope scope(operation::gcd);
+    // (|lhs|, |rhs|) = m (a, b) with det(m) = 1, so once one of a and b is zero,
+    // the other is a combination of |lhs| and |rhs| taken from a row of m^-1.
+    bigint a = from_limbs(lhs.array, lhs.num_limbs());
+    bigint b = from_limbs(rhs.array, rhs.num_limbs());
+    bigint m[4] = {1, 0, 0, 1};
+    gcd_reduce(a, b, m);
+
+    std::tuple<bigint, bigint, bigint> result;
+    if (b.num_limbs() || !a.num_limbs()) {
+        std::get<0>(result) = std::move(b);
+        std::get<1>(result) = -m[2];
+        std::get<2>(result) = std::move(m[0]);
+    } else {
+        std::get<0>(result) = std::move(a);
+        std::get<1>(result) = std::move(m[3]);
+        std::get<2>(result) = -m[1];
+    }
+    if (!std::get<0>(result).num_limbs()) {
+        std::get<1>(result) = zero;
+        std::get<2>(result) = zero;
+    }
+    if (lhs.is_negative) std::get<1>(result) = -std::get<1>(result);
+    if (rhs.is_negative) std::get<2>(result) = -std::get<2>(result);
+    return result;
+}
+
+bigint bigint::invert(const bigint& a, const bigint& mod) {
+    const operation_scope scope(operation::gcd);
+    const size_t n = mod.num_limbs();
+    if (!n) throw std::invalid_argument("Divide by zero error.");
+    const bigint m = from_limbs(mod.array, n);
+    bigint r = a % m;
+    if (r.is_negative) r += m;
+    std::tuple<bigint, bigint, bigint> g = gcdext(r, m);
+    if (std::get<0>(g) != 1) throw std::invalid_argument("Value is not invertible modulo m.");
+    bigint& inv = std::get<1>(g);
+    inv %= m;
+    if (inv.is_negative) inv += m;
+    return inv;
+}
+
+std::pair<bigint, bigint> bigint::divmod(const bigint& lhs, const bigint& rhs, rounding mode) {
+    std::pair<bigint, bigint> result;
+    divide(lhs, rhs, &result.first, &result.second);
+    if (mode == rounding::floor && result.second.num_limbs() && lhs.is_negative != rhs.is_negative) {
+        --result.first;
+        result.second += rhs;
+    }
+    return result;
+}
+
+void bigint::addmul(bigint& acc, const bigint& a, const bigint& b) {
+    fused_multiply_add(acc, a, b, false);
+}
+
+void bigint::submul(bigint& acc, const bigint& a, const bigint& b) {
+    fused_multiply_add(acc, a, b, true);
+}
+
+void bigint::addmul(bigint& acc, const bigint& a, uint64_t b) {
+    fused_multiply_add(acc, a, bigint(b), false);
+}
+
+void bigint::submul(bigint& acc, const bigint& a, uint64_t b) {
+    fused_multiply_add(acc, a, bigint(b), true);
+}
+
+bigint bigint::mul_fft(const bigint& lhs, const bigint& rhs) {
+    const size_t ln = lhs.num_limbs();
+    const size_t rn = rhs.num_limbs();
+    if (!ln || !rn) return zero;
+
+    bigint result;
+    result.reserve(ln + rn);
+    mul_ntt(result.array, lhs.array, ln, rhs.array, rn);
+    result.is_negative = lhs.is_negative != rhs.is_negative;
+    result.trim();
+    return result;
+}
+
+namespace {
+    // The odd primes up to n, from a sieve over odd numbers only.
+    std::vector<limb> odd_primes(limb n) {
+        std::vector<limb> primes;
+        if (n < 3) return primes;
+        std::vector<bool> composite((n - 1) / 2);
+        for (limb i = 3; i <= n; i += 2) {
+            if (composite[i / 2 - 1]) continue;
+            primes.push_back(i);
+            if (i > n / i) continue;
+            for (limb j = i * i; j <= n; j += 2 * i) {
+                composite[j / 2 - 1] = true;
+            }
+        }
+        return primes;
+    }
+
+    // The exponent of the prime p in n!.
+    limb legendre(limb n, limb p) {
+        limb e = 0;
+        while (n) {
+            n /= p;
+            e += n;
+        }
+        return e;
+    }
+
+    // The product of f[0..n), split in halves so that the large multiplications
+    // see balanced operands.
+    bigint product(const limb* f, size_t n) {
+        if (n <= 16) {
+            bigint result = 1;
+            for (size_t i = 0; i < n; i++) {
+                result *= f[i];
+            }
+            return result;
+        }
+        return product(f, n / 2) * product(f + n / 2, n - n / 2);
+    }
 
-    bool both_zero = true;
-    size_t i = 0;
-    while (i < lhs.capacity || i < rhs.capacity) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (lbyte != rbyte) return false;
-        else if (lbyte) both_zero = false;
-        ++i;
+    // Multiplies runs of factors together while they fit in a limb, so the
+    // product tree starts from full limbs.
+    void pack(std::vector<limb>& f) {
+        size_t k = 0;
+        limb acc = 1;
+        for (limb x : f) {
+            const dlimb p = static_cast<dlimb>(acc) * x;
+            if (p >> 64) {
+                f[k++] = acc;
+                acc = x;
+            } else {
+                acc = static_cast<limb>(p);
+            }
+        }
+        f.resize(k);
+        f.push_back(acc);
     }
-    if (!both_zero && (lhs.is_negative != rhs.is_negative)) return false;
-    
-    return true;
-}
 
-bool bigint::operator != (const bigint& rhs) const {
-    return !this->operator==(rhs);
+    // The product of p^e over the given primes and exponents. Bit j of each
+    // exponent puts its prime into the j-th factor, and the factors are combined
+    // from the top bit down by squaring, which is cheaper than multiplying.
+    bigint prime_power_product(const std::vector<limb>& primes, const std::vector<limb>& exps) {
+        limb top = 0;
+        for (limb e : exps) top |= e;
+        bigint result = 1;
+        std::vector<limb> f;
+        for (int j = 63 - __builtin_clzll(top | 1); j >= 0; j--) {
+            f.clear();
+            for (size_t i = 0; i < primes.size(); i++) {
+                if ((exps[i] >> j) & 0x1) f.push_back(primes[i]);
+            }
+            pack(f);
+            result *= result;
+            result *= product(f.data(), f.size());
+        }
+        return result;
+    }
 }
 
-bool bigint::operator < (const bigint& rhs) const {
-    const bigint& lhs = *this;
+bigint bigint::factorial(const bigint& n) {
+    const operation_scope scope(operation::power);
+    if (n < 0) throw std::invalid_argument("Cannot take factorial of negative number.");
 
-    if (lhs.is_negative) {
-        return -lhs > -rhs;
+    // n! = 2^(n - popcount(n)) * (product of the odd primes p <= n to their
+    // Legendre exponents).
+    const limb m = static_cast<unsigned long long>(n);
+    const std::vector<limb> primes = odd_primes(m);
+    std::vector<limb> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); i++) {
+        exps[i] = legendre(m, primes[i]);
     }
+    return prime_power_product(primes, exps) << (m - __builtin_popcountll(m));
+}
 
-    if (rhs.is_negative) return false;
+bigint bigint::double_factorial(const bigint& n) {
+    const operation_scope scope(operation::power);
+    if (n < 0) throw std::invalid_argument("Cannot take double factorial of negative number.");
 
-    size_t i = (lhs.capacity > rhs.capacity) ? lhs.capacity : rhs.capacity;
-    while (i-- > 0) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (lbyte < rbyte) return true;
-        else if (lbyte > rbyte) return false;
+    const limb m = static_cast<unsigned long long>(n);
+    if (!(m & 0x1)) return factorial(m / 2) << (m / 2);
+
+    // (2h + 1)!! = (2h + 1)! / (2^h * h!), whose odd primes have exponents
+    // e_p((2h + 1)!) - e_p(h!).
+    const std::vector<limb> primes = odd_primes(m);
+    std::vector<limb> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); i++) {
+        exps[i] = legendre(m, primes[i]) - legendre(m / 2, primes[i]);
     }
-    return false;
+    return prime_power_product(primes, exps);
 }
 
-bool bigint::operator > (const bigint& rhs) const {
-    const bigint& lhs = *this;
+bigint bigint::binomial(const bigint& n, const bigint& k) {
+    const operation_scope scope(operation::power);
+    if (k < 0) return zero;
+    if (n < 0) {
+        // C(n, k) = (-1)^k * C(k - n - 1, k).
+        bigint result = binomial(k - n - 1, k);
+        if (k.num_limbs() && (k.array[0] & 0x1)) result.is_negative = true;
+        return result;
+    }
+    if (k > n) return zero;
+
+    const limb nn = static_cast<unsigned long long>(n);
+    limb kk = static_cast<unsigned long long>(k);
+    kk = std::min(kk, nn - kk);
+    if (!kk) return 1;
+
+    if (kk < nn / 64) {
+        // Far from the middle, sieving up to n costs more than dividing the
+        // falling factorial n (n - 1) ... (n - k + 1) by k!.
+        std::vector<limb> f(kk);
+        for (limb i = 0; i < kk; i++) {
+            f[i] = nn - i;
+        }
+        pack(f);
+        return product(f.data(), f.size()) / factorial(kk);
+    }
 
-    if (lhs.is_negative) {
-        return -lhs < -rhs;
+    // By Kummer, 2 divides C(n, k) popcount(k) + popcount(n - k) - popcount(n) times.
+    const std::vector<limb> primes = odd_primes(nn);
+    std::vector<limb> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); i++) {
+        exps[i] = legendre(nn, primes[i]) - legendre(kk, primes[i]) - legendre(nn - kk, primes[i]);
+    }
+    return prime_power_product(primes, exps) << (__builtin_popcountll(kk) + __builtin_popcountll(nn - kk) - __builtin_popcountll(nn));
+}
+
+namespace {
+    // floor(x^(1/k)) for 2 <= k < 64, from a floating-point estimate corrected
+    // in integers.
+    limb root_1(limb x, limb k) {
+        auto exceeds = [&](limb r) {
+            dlimb p = 1;
+            for (limb i = 0; i < k; i++) {
+                p *= r;
+                if (p > x) return true;
+            }
+            return false;
+        };
+        limb r = static_cast<limb>(std::pow(static_cast<long double>(x), 1.0L / k));
+        while (r && exceeds(r)) --r;
+        while (!exceeds(r + 1)) ++r;
+        return r;
     }
 
-    size_t i = (lhs.capacity > rhs.capacity) ? lhs.capacity : rhs.capacity;
-    while (i-- > 0) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (rhs.is_negative) {
-            if (lbyte || rbyte) return true;
-        } else {
-            if (lbyte > rbyte) return true;
-            else if (lbyte < rbyte) return false;
+    bool is_prime_1(limb q) {
+        if (q < 2) return false;
+        for (limb d = 2; d <= q / d; d++) {
+            if (q % d == 0) return false;
         }
+        return true;
     }
-    return false;
-}
 
-bool bigint::operator <= (const bigint& rhs) const {
-    return !this->operator>(rhs);
-}
+    limb powmod_1(limb b, limb e, limb m) {
+        limb r = 1;
+        for (b %= m; e; e >>= 1) {
+            if (e & 0x1) r = static_cast<dlimb>(r) * b % m;
+            b = static_cast<dlimb>(b) * b % m;
+        }
+        return r;
+    }
 
-bool bigint::operator >= (const bigint& rhs) const {
-    return !this->operator<(rhs);
+    // False if a > 0 is certainly not a k-th power. Modulo a prime q = 1 (mod k),
+    // only (q - 1) / k of the nonzero residues are k-th powers, so each prime
+    // tried rejects all but about 1/k of the non-powers.
+    bool maybe_power(const bigint& a, limb k) {
+        int tried = 0;
+        for (limb q = k + 1; tried < 4; q += k) {
+            if (!is_prime_1(q)) continue;
+            tried++;
+            const limb r = static_cast<unsigned long long>(a % q);
+            if (r && powmod_1(r, (q - 1) / k, q) != 1) return false;
+        }
+        return true;
+    }
 }
 
-// MARK: Binary Arithmetic Operators
-
-bigint bigint::operator + (const bigint& rhs) const {
-    const bigint& lhs = *this;
+std::pair<bigint, bigint> bigint::rootrem(const bigint& n, uint64_t k) {
+    const operation_scope scope(operation::power);
+    if (!k) throw std::invalid_argument("Cannot take zeroth root.");
+    if (n.is_negative && !(k & 0x1)) throw std::invalid_argument("Cannot take even root of negative number.");
 
-    if (lhs.is_negative != rhs.is_negative) {
-        return lhs - (-rhs);
+    std::pair<bigint, bigint> result;
+    const size_t bits = n.bit_length();
+    if (k == 1 || !bits) {
+        result.first = n;
+        return result;
     }
 
-    bigint result;
-    result.is_negative = lhs.is_negative;
-
-    bool carry = false;
-    size_t i = 0;
-    while (i < lhs.capacity || i < rhs.capacity) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (i == result.capacity) result.grow();
-        result.array[i] = lbyte + rbyte + (carry ? 1 : 0);
-        carry = (!carry && lbyte > (rbyte ^ 0xFF)) || (carry && lbyte >= (rbyte ^ 0xFF));
-        ++i;
+    const bigint a = from_limbs(n.array, n.num_limbs());
+    bigint& x = result.first;
+    if (k >= bits || bits <= 64) {
+        const limb r = (k >= bits) ? 1 : root_1(a.array[0], k);
+        x = r;
+        result.second = a - pow(x, k);
+        if (n.is_negative) {
+            x.is_negative = true;
+            result.second = -result.second;
+        }
+        return result;
     }
-    if (carry) {
-        if (i == result.capacity) result.grow();
-        result.array[i] = 0x01;
+    // Newton's method on x^k - a. A step from any positive x lands at or above
+    // the root, and steps from above decrease to it.
+    auto step = [&](const bigint& q) {
+        bigint t = a / q;
+        addmul(t, x, k - 1);
+        x = t / k;
+    };
+    if (bits / k < 64) {
+        // The root fits in a limb, so a floating-point estimate from the top
+        // 64 bits is close. It is rounded up past its error to start from above,
+        // since a step from below overshoots by far when the root is small.
+        const size_t shift = bits - 64;
+        const limb top = static_cast<unsigned long long>(a >> shift);
+        const long double e = (std::log2(static_cast<long double>(top)) + shift) / k;
+        const limb est = static_cast<limb>(std::exp2(e));
+        x = est;
+        x += (est >> 40) + 2;
+    } else {
+        // The root of a / 2^(kj) shifted back by j bits is below the root of a
+        // by a factor of at most 1 + 2^-(bits/k - j), so one step from it leaves
+        // an error of at most about 1. Each level thus doubles the precision,
+        // and the divisions run at the sizes the levels need.
+        const size_t lg = 64 - __builtin_clzll(k - 1);
+        const size_t j = (bits / k - lg - 2) / 2;
+        x = rootrem(a >> (k * j), k).first << j;
+        step(pow(x, k - 1));
     }
 
+    bigint p = pow(x, k);
+    while (p > a) {
+        // Usually x is at most 1 too large, so try x - 1 before another step.
+        --x;
+        const bigint q = pow(x, k - 1);
+        p = q * x;
+        if (p > a) {
+            step(q);
+            p = pow(x, k);
+        }
+    }
+    result.second = a - p;
+    if (n.is_negative) {
+        x.is_negative = true;
+        result.second = -result.second;
+    }
     return result;
 }
 
-bigint bigint::operator - (const bigint& rhs) const {
-    const bigint& lhs = *this;
+std::pair<bigint, bigint> bigint::sqrtrem(const bigint& n) {
+    return rootrem(n, 2);
+}
 
-    if (lhs.is_negative != rhs.is_negative) {
-        return lhs + (-rhs);
-    }
+bigint bigint::iroot(const bigint& n, uint64_t k) {
+    return rootrem(n, k).first;
+}
 
-    bool right_greater = (rhs > lhs);
-    bool right_larger = right_greater != rhs.is_negative;
-    const bigint& larger = right_larger ? rhs : lhs;
-    const bigint& smaller = right_larger ? lhs : rhs;
+bigint bigint::isqrt(const bigint& n) {
+    return rootrem(n, 2).first;
+}
 
-    bigint result;
-    result.is_negative = right_greater;
+bool bigint::is_square(const bigint& n) {
+    if (n.is_negative) return false;
+    if (!n.num_limbs()) return true;
+    // Squares are 0, 1, 4 or 9 mod 16.
+    if (!((0x213 >> (n.array[0] & 0xf)) & 0x1)) return false;
+    return maybe_power(n, 2) && !rootrem(n, 2).second.num_limbs();
+}
 
-    size_t i = 0;
-    bool borrow = false;
-    while (i < larger.capacity || i < smaller.capacity) {
-        const byte lbyte = (i < larger.capacity) ? larger.array[i] : 0;
-        const byte sbyte = (i < smaller.capacity) ? smaller.array[i] : 0;
-        if (i == result.capacity) result.grow();
-        result.array[i] = lbyte - sbyte - (borrow ? 1 : 0);
-        borrow = (!borrow && sbyte > lbyte) || (borrow && sbyte >= lbyte);
-        ++i;
+bool bigint::is_perfect_power(const bigint& n) {
+    const operation_scope scope(operation::power);
+    const size_t m = n.num_limbs();
+    if (!m) return true;
+    const bigint a = from_limbs(n.array, m);
+    const size_t bits = a.bit_length();
+    if (bits == 1) return true;
+
+    // a = r^k with k > 1 means a is a p-th power for each prime p dividing k,
+    // so only prime exponents need testing. A p-th power also has a multiple of
+    // p trailing zeros.
+    size_t zeros = 0;
+    for (size_t i = 0; !a.array[i]; i++) zeros += 64;
+    zeros += __builtin_ctzll(a.array[zeros / 64]);
+
+    std::vector<limb> primes = odd_primes(bits);
+    if (!n.is_negative) primes.insert(primes.begin(), 2);
+    for (limb p : primes) {
+        if (zeros % p) continue;
+        if (!maybe_power(a, p)) continue;
+        if (!rootrem(a, p).second.num_limbs()) return true;
     }
+    return false;
+}
 
-    return result;
+std::pmr::memory_resource* bigint::default_resource() {
+    return thread_resource ? thread_resource : std::pmr::get_default_resource();
 }
 
-bigint bigint::operator * (const bigint& rhs) const {
-    const bigint& lhs = *this;
+void bigint::set_default_resource(std::pmr::memory_resource* mr) {
+    thread_resource = mr;
+    thread_mapped = dynamic_cast<bigint_mmap_resource*>(mr);
+}
 
-    bigint result;
-    for (size_t i = 0; i < lhs.capacity; i++) {
-        bigint line;
-        while (line.capacity < i) line.grow();
-        dbyte lbyte = lhs.array[i];
-        dbyte carry = 0;  // carry & lbyte are really only bytes, but this avoids unnecessary conversions
-        for (size_t j = 0; j < rhs.capacity; j++) {
-            dbyte prod = lbyte * static_cast<dbyte>(rhs.array[j]) + carry;
-            if (line.capacity == i + j) line.grow();
-            line.array[i + j] = prod & 0xFF;
-            carry = prod >> 8;
-        }
-        if (carry) {
-            if (line.capacity == i + rhs.capacity) line.grow();
-            line.array[i + rhs.capacity] = carry;
-        }
-        result += line;
-    }
-    result.is_negative = lhs.is_negative != rhs.is_negative;
-    result.trim();
-    return result;
+std::pmr::memory_resource* bigint::get_resource() const {
+    return resource;
 }
 
-bigint bigint::operator / (const bigint& rhs) const {
-    const bigint& lhs = *this;
-    bigint rhs_trim = rhs;
-    rhs_trim.trim();
+// MARK: Memory Resources
 
-    if (!rhs_trim.capacity) throw std::invalid_argument("Divide by zero error.");
+bigint_arena::bigint_arena(size_t initial_size, std::pmr::memory_resource* mr)
+    :upstream(mr), chunks(nullptr), cursor(nullptr), remaining(0), next_size(initial_size), allocated(0) {}
 
-    bigint result;
-    size_t nb = lhs.num_bytes();
-    while(result.capacity < nb) result.grow();
+bigint_arena::~bigint_arena() {
+    release();
+}
 
-    bigint diff;
-    for (size_t i = nb; i-- > 0; ) {
-        diff <<= 8;
-        diff |= lhs.array[i];
-        byte count = 0;
-        while (diff >= rhs_trim) {
-            diff -= rhs_trim;
-            ++count;
-        }
-        result.array[i] = count;
+void bigint_arena::release() {
+    while (chunks) {
+        chunk* next = chunks->next;
+        upstream->deallocate(chunks, chunks->size, alignof(std::max_align_t));
+        chunks = next;
     }
-    result.is_negative = lhs.is_negative != rhs.is_negative;
-    return result;
+    cursor = nullptr;
+    remaining = 0;
+    allocated = 0;
+}
+
+size_t bigint_arena::bytes_allocated() const {
+    return allocated;
+}
+
+void* bigint_arena::do_allocate(size_t bytes, size_t alignment) {
+    size_t padding = -reinterpret_cast<uintptr_t>(cursor) & (alignment - 1);
+    if (padding + bytes > remaining) {
+        // Start a new chunk, at least doubling each time so the number of chunks
+        // stays logarithmic in the total.
+        size_t size = sizeof(chunk) + bytes + alignment;
+        if (size < next_size) size = next_size;
+        next_size = 2 * size;
+        chunk* c = static_cast<chunk*>(upstream->allocate(size, alignof(std::max_align_t)));
+        c->next = chunks;
+        c->size = size;
+        chunks = c;
+        cursor = reinterpret_cast<char*>(c + 1);
+        remaining = size - sizeof(chunk);
+        padding = -reinterpret_cast<uintptr_t>(cursor) & (alignment - 1);
+    }
+    void* p = cursor + padding;
+    cursor += padding + bytes;
+    remaining -= padding + bytes;
+    allocated += bytes;
+    return p;
 }
 
-bigint bigint::operator % (const bigint& rhs) const {
-    const bigint& lhs = *this;
-    bigint rhs_trim = rhs;
-    rhs_trim.trim();
+void bigint_arena::do_deallocate(void*, size_t, size_t) {}
 
-    if (!rhs_trim.capacity) throw std::invalid_argument("Divide by zero error.");
+bool bigint_arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
 
-    bigint result;
-    size_t nb = lhs.num_bytes();
+namespace {
+    // Per-thread free lists for bigint_pool, one per power-of-two size class.
+    // Blocks are plain upstream allocations, so a block freed on another thread
+    // simply joins that thread's list.
+    struct pool_cache {
+        static constexpr size_t classes = 20;
+        static constexpr size_t max_blocks = 64;
 
-    for (size_t i = nb; i-- > 0; ) {
-        result <<= 8;
-        result |= lhs.array[i];
-        while (result >= rhs_trim) {
-            result -= rhs_trim;
-        }
-    }
-    result.is_negative = lhs.is_negative;
-    result.trim();
-    return result;
-}
+        struct block {
+            block* next;
+        };
+        block* heads[classes] = {};
+        size_t counts[classes] = {};
 
-// MARK: Arithmetic Assignment Operators
+        ~pool_cache();
+    };
 
-bigint& bigint::operator += (const bigint& other) {
-    if (is_negative != other.is_negative) {
-        this->operator-=(-other);
-        return *this;
-    }
+    thread_local bool pool_cache_destroyed = false;
+    thread_local pool_cache cache;
 
-    bool carry = false;
-    size_t i = 0;
-    while (i < capacity || i < other.capacity) {
-        const byte tbyte = (i < capacity) ? array[i] : 0;
-        const byte obyte = (i < other.capacity) ? other.array[i] : 0;
-        if (i == capacity) grow();
-        array[i] = tbyte + obyte + (carry ? 1 : 0);
-        carry = (!carry && tbyte > (obyte ^ 0xFF)) || (carry && tbyte >= (obyte ^ 0xFF));
-        ++i;
+    pool_cache::~pool_cache() {
+        for (size_t c = 0; c < classes; c++) {
+            while (heads[c]) {
+                block* next = heads[c]->next;
+                ::operator delete(heads[c]);
+                heads[c] = next;
+            }
+        }
+        pool_cache_destroyed = true;
     }
-    if (carry) {
-        if (i == capacity) grow();
-        array[i] = 0x01;
+
+    // The size class holding blocks of 16 << c bytes, or pool_cache::classes if
+    // the request is too large or too strictly aligned to pool.
+    size_t size_class(size_t bytes, size_t alignment) {
+        if (alignment > alignof(std::max_align_t)) return pool_cache::classes;
+        size_t c = 0;
+        while (c < pool_cache::classes && (static_cast<size_t>(16) << c) < bytes) ++c;
+        return c;
     }
+}
 
-    return *this;
+void* bigint_pool::do_allocate(size_t bytes, size_t alignment) {
+    const size_t c = size_class(bytes, alignment);
+    if (c == pool_cache::classes) return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    if (!pool_cache_destroyed && cache.heads[c]) {
+        pool_cache::block* b = cache.heads[c];
+        cache.heads[c] = b->next;
+        --cache.counts[c];
+        return b;
+    }
+    return ::operator new(static_cast<size_t>(16) << c);
 }
 
-bigint& bigint::operator -= (const bigint& other) {
-    if (is_negative != other.is_negative) {
-        return this->operator+=(-other);
+void bigint_pool::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    const size_t c = size_class(bytes, alignment);
+    if (c == pool_cache::classes) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    } else if (pool_cache_destroyed || cache.counts[c] == pool_cache::max_blocks) {
+        ::operator delete(p);
+    } else {
+        pool_cache::block* b = static_cast<pool_cache::block*>(p);
+        b->next = cache.heads[c];
+        cache.heads[c] = b;
+        ++cache.counts[c];
     }
+}
 
-    bool right_greater = (other > *this);
-    bool right_larger = right_greater != other.is_negative;
-    const bigint& larger = right_larger ? other : *this;
-    const bigint& smaller = right_larger ? *this : other;
+bool bigint_pool::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    // All pools share the same per-thread lists.
+    return dynamic_cast<const bigint_pool*>(&other) != nullptr;
+}
 
-    is_negative = right_greater;
+namespace {
+    // The header page at the start of each mapping made by bigint_mmap_resource.
+    struct mapping_header {
+        int fd;
+        size_t length;
+    };
 
-    size_t i = 0;
-    bool borrow = false;
-    while (i < larger.capacity || i < smaller.capacity) {
-        const byte lbyte = (i < larger.capacity) ? larger.array[i] : 0;
-        const byte sbyte = (i < smaller.capacity) ? smaller.array[i] : 0;
-        if (i == capacity) grow();
-        array[i] = lbyte - sbyte - (borrow ? 1 : 0);
-        borrow = (!borrow && sbyte > lbyte) || (borrow && sbyte >= lbyte);
-        ++i;
+    size_t page_size() {
+        static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
     }
 
-    return *this;
+    // The length of a mapping holding the header page and the given bytes.
+    size_t mapping_length(size_t bytes) {
+        const size_t page = page_size();
+        return page + (bytes + page - 1) / page * page;
+    }
 }
 
-bigint& bigint::operator *= (const bigint& other) {
-    return this->operator=(std::move(this->operator*(other)));
+bigint_mmap_resource::bigint_mmap_resource(std::string dir, size_t min_bytes, std::pmr::memory_resource* mr)
+    :directory(std::move(dir)), threshold(min_bytes), upstream(mr) {
+    if (directory.empty()) {
+        const char* tmp = std::getenv("TMPDIR");
+        directory = (tmp && *tmp) ? tmp : "/tmp";
+    }
 }
 
-bigint& bigint::operator /= (const bigint& other) {
-    return this->operator=(std::move(this->operator/(other)));
+bool bigint_mmap_resource::mapped(size_t bytes, size_t alignment) const {
+    return bytes && bytes >= threshold && alignment <= page_size();
 }
 
-bigint& bigint::operator %= (const bigint& other) {
-    return this->operator=(std::move(this->operator%(other)));
+void* bigint_mmap_resource::do_allocate(size_t bytes, size_t alignment) {
+    if (!mapped(bytes, alignment)) return upstream->allocate(bytes, alignment);
+    // The file is unlinked at once, so it disappears with its last mapping
+    // even if the process dies.
+    std::string path = directory + "/bigint-XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0) throw std::bad_alloc();
+    unlink(path.c_str());
+    const size_t length = mapping_length(bytes);
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) == 0) {
+        base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw std::bad_alloc();
+    }
+    mapping_header* header = static_cast<mapping_header*>(base);
+    header->fd = fd;
+    header->length = length;
+    return static_cast<char*>(base) + page_size();
 }
 
-// MARK: Binary Bitwise Operators
-
-bigint bigint::operator & (const bigint& rhs) const {
-    const bigint& lhs = *this;
+void bigint_mmap_resource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!mapped(bytes, alignment)) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    void* base = static_cast<char*>(p) - page_size();
+    const mapping_header header = *static_cast<mapping_header*>(base);
+    munmap(base, header.length);
+    close(header.fd);
+}
+
+void* bigint_mmap_resource::reallocate(void* p, size_t old_bytes, size_t new_bytes, size_t alignment) {
+    if (!mapped(old_bytes, alignment) || !mapped(new_bytes, alignment)) return nullptr;
+    char* base = static_cast<char*>(p) - page_size();
+    const mapping_header header = *reinterpret_cast<mapping_header*>(base);
+    const size_t length = mapping_length(new_bytes);
+    if (length == header.length) return p;
+
+    // Grow the file before the mapping and shrink it after, so the mapping
+    // never extends past the end of the file.
+    if (length > header.length && ftruncate(header.fd, static_cast<off_t>(length)) != 0) return nullptr;
+#ifdef MREMAP_MAYMOVE
+    void* moved = mremap(base, header.length, length, MREMAP_MAYMOVE);
+#else
+    // Without mremap, map the file again; the pages are shared, so nothing is
+    // copied either way.
+    void* moved = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, header.fd, 0);
+    if (moved != MAP_FAILED) munmap(base, header.length);
+#endif
+    if (moved == MAP_FAILED) return nullptr;
+    if (length < header.length) ftruncate(header.fd, static_cast<off_t>(length));
+    static_cast<mapping_header*>(moved)->length = length;
+    return static_cast<char*>(moved) + page_size();
+}
+
+bool bigint_mmap_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// MARK: Modular Arithmetic
+
+namespace {
+    // Left-to-right sliding-window exponentiation, where mul(r, a, b) sets r to
+    // the product of a and b in whatever representation T uses (r may alias
+    // either operand) and one is the identity.
+    template<typename T, typename Mul>
+    T window_pow(const T& g, const limb* e, size_t en, const T& one, Mul mul) {
+        if (!en) return one;
+        const size_t bits = 64 * en - __builtin_clzll(e[en - 1]);
+        const size_t k = (bits > 671) ? 6 : (bits > 239) ? 5 : (bits > 79) ? 4 : (bits > 23) ? 3 : 1;
+        auto bit = [&](size_t i) {return static_cast<unsigned int>(e[i / 64] >> (i % 64)) & 0x1;};
+
+        // Odd powers g, g^3, ..., g^(2^k - 1).
+        std::vector<T> table(static_cast<size_t>(1) << (k - 1), g);
+        if (k > 1) {
+            T g2 = g;
+            mul(g2, g, g);
+            for (size_t i = 1; i < table.size(); i++) {
+                mul(table[i], table[i - 1], g2);
+            }
+        }
 
-    bigint result;
-    size_t i = 0;
-    while (i < lhs.capacity && i < rhs.capacity) {
-        if (i == result.capacity) result.grow();
-        result.array[i] = lhs.array[i] & rhs.array[i];
-        ++i;
+        T result = one;
+        bool started = false;
+        for (size_t i = bits; i > 0; ) {
+            if (!bit(i - 1)) {
+                mul(result, result, result);
+                --i;
+                continue;
+            }
+            size_t j = (i > k) ? i - k : 0;
+            while (!bit(j)) ++j;
+            size_t window = 0;
+            for (size_t t = i; t-- > j; ) {
+                window = 2 * window + bit(t);
+            }
+            if (started) {
+                for (size_t t = j; t < i; t++) {
+                    mul(result, result, result);
+                }
+                mul(result, result, table[window / 2]);
+            } else {
+                result = table[window / 2];
+                started = true;
+            }
+            i = j;
+        }
+        return result;
     }
-    return result;
 }
 
-bigint bigint::operator | (const bigint& rhs) const {
-    const bigint& lhs = *this;
+namespace {
+    // Products awaiting reduction by a bigint_mod_context.
+    thread_local bigint modular_scratch(std::pmr::new_delete_resource());
+}
 
-    bigint result;
-    size_t i = 0;
-    while (i < lhs.capacity || i < rhs.capacity) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (i == result.capacity) result.grow();
-        result.array[i] = lbyte | rbyte;
-        ++i;
+bigint_mod_context::bigint_mod_context(const bigint& modulus) : m(bigint::from_limbs(modulus.array, modulus.num_limbs())), n(m.num_limbs()), m_inv(0) {
+    if (!n) throw std::invalid_argument("Divide by zero error.");
+    if (m.array[0] & 0x1) {
+        // Residues are held as x * B^n mod m, and products are reduced with redc.
+        limb x = m.array[0];
+        for (int i = 0; i < 5; i++) x *= 2 - m.array[0] * x;
+        m_inv = -x;
+        r2 = (bigint(1) << (128 * n)) % m;
+        r2.reserve(n);
+    } else {
+        inv = bigint::newton_reciprocal(m);
     }
-    return result;
 }
 
-bigint bigint::operator ^ (const bigint& rhs) const {
-    const bigint& lhs = *this;
-
-    bigint result;
-    size_t i = 0;
-    while (i < lhs.capacity || i < rhs.capacity) {
-        const byte lbyte = (i < lhs.capacity) ? lhs.array[i] : 0;
-        const byte rbyte = (i < rhs.capacity) ? rhs.array[i] : 0;
-        if (i == result.capacity) result.grow();
-        result.array[i] = lbyte ^ rbyte;
-        ++i;
-    }
-    return result;
+const bigint& bigint_mod_context::modulus() const {
+    return m;
 }
 
-bigint bigint::operator << (size_t rhs) const {
-    const bigint& lhs = *this;
+bigint_mod_context::residue bigint_mod_context::operator()(const bigint& x) const {
+    bigint r = x % m;
+    if (r.is_negative) r += m;
+    r.reserve(n);
+    if (m_inv) mul(r, r, r2);
+    return residue(this, std::move(r));
+}
 
-    size_t nb = lhs.num_bytes();
-    if (nb == 0) return zero;
+bigint_mod_context::residue bigint_mod_context::pow(const residue& base, const bigint& exp) const {
+    if (base.ctx != this) throw std::invalid_argument("Residues belong to different moduli.");
+    if (exp.is_negative) return pow((*this)(bigint::invert(base.value(), m)), -exp);
+    auto multiply = [this](residue& r, const residue& a, const residue& b) {mul(r.limbs, a.limbs, b.limbs);};
+    return window_pow(base, exp.array, exp.num_limbs(), (*this)(1), multiply);
+}
 
-    bigint result;    
-    byte shamt = rhs % 8;
-    size_t offset = rhs / 8;
-    byte extra = lhs.array[nb - 1] >> (8 - shamt);
+void bigint_mod_context::mul(bigint& r, const bigint& a, const bigint& b) const {
+    bigint& t = modular_scratch;
+    if (m_inv) {
+        t.reserve(2 * n + 1);
+        bigint::mul_limbs(t.array, a.array, n, b.array, n);
+        t.array[2 * n] = 0;
+        r.reserve(n);
+        redc(r.array, t.array, m.array, n, m_inv);
+    } else {
+        // Barrett: the quotient estimate (t / B^(n-1)) * inv / B^(n+1) is at most
+        // two short, and the remainder only needs its low n + 1 limbs.
+        const size_t in = inv.num_limbs();
+        t.reserve(4 * n + 2 * in + 1);
+        limb* q = t.array + 2 * n;
+        limb* p = q + n + 1 + in;
+        bigint::mul_limbs(t.array, a.array, n, b.array, n);
+        bigint::mul_limbs(q, t.array + n - 1, n + 1, inv.array, in);
+        bigint::mul_limbs(p, q + n + 1, in, m.array, n);
+        sub_n(t.array, t.array, p, n + 1);
+        while (t.array[n] || cmp(t.array, n, m.array, n) >= 0) {
+            t.array[n] -= sub_n(t.array, t.array, m.array, n);
+        }
+        r.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            r.array[i] = t.array[i];
+        }
+    }
+    r.normalize(n);
+}
 
-    while (result.capacity < nb + offset + (extra ? 1 : 0)) {
-        if (result.capacity > std::numeric_limits<size_t>().max() / 2) throw std::overflow_error("Logical shift error: shift too large.");
-        else result.grow();
+void bigint_mod_context::add(bigint& r, const bigint& a, const bigint& b) const {
+    r.reserve(n);
+    if (add_n(r.array, a.array, b.array, n) || cmp(r.array, n, m.array, n) >= 0) {
+        sub_n(r.array, r.array, m.array, n);
     }
+    r.normalize(n);
+}
 
-    for (size_t i = nb; i-- > 0; ) {
-        if (lhs.array[i] >> (8 - shamt)) result.array[i + offset + 1] |= lhs.array[i] >> (8 - shamt);
-        result.array[i + offset] |= lhs.array[i] << shamt;
+void bigint_mod_context::sub(bigint& r, const bigint& a, const bigint& b) const {
+    r.reserve(n);
+    if (sub_n(r.array, a.array, b.array, n)) {
+        add_n(r.array, r.array, m.array, n);
     }
+    r.normalize(n);
+}
 
-    return result;
+void bigint_mod_context::check(const residue& a, const residue& b) const {
+    if (a.ctx != b.ctx) throw std::invalid_argument("Residues belong to different moduli.");
 }
 
-bigint bigint::operator >> (size_t rhs) const {
-    const bigint & lhs = *this;
-    
-    size_t nb = lhs.num_bytes();
-    byte shamt = rhs % 8;
-    size_t offset = rhs / 8;
-    if (offset > nb) return zero;
+bigint_mod_context::residue::residue(const bigint_mod_context* c, bigint x) : ctx(c), limbs(std::move(x)) {}
 
-    bigint result;
-    byte extra = lhs.array[nb - 1] >> shamt;
+bigint_mod_context::residue::residue(const residue& other) : ctx(other.ctx), limbs(other.limbs) {
+    limbs.reserve(ctx->n);
+}
 
-    while (result.capacity < nb - offset - (extra ? 0 : 1)) result.grow();
-    
-    for (size_t i = offset; i < nb; i++) {
-        if (lhs.array[i] >> shamt) result.array[i - offset] |= lhs.array[i] >> shamt;
-        if (i < nb - 1) result.array[i - offset] |= lhs.array[i + 1] << (8 - shamt);
-    }
+bigint_mod_context::residue::residue(residue&& other) : ctx(other.ctx), limbs(std::move(other.limbs)) {
+    limbs.reserve(ctx->n);
+}
 
-    return result;
+bigint_mod_context::residue& bigint_mod_context::residue::operator=(const residue& other) {
+    ctx = other.ctx;
+    limbs = other.limbs;
+    limbs.reserve(ctx->n);
+    return *this;
 }
 
-// MARK: Bitwise Assignment Operators
+// Moving between memory resources copies, which only keeps the used limbs.
+bigint_mod_context::residue& bigint_mod_context::residue::operator=(residue&& other) {
+    ctx = other.ctx;
+    limbs = std::move(other.limbs);
+    limbs.reserve(ctx->n);
+    return *this;
+}
 
-bigint& bigint::operator &= (const bigint& other) {
-    size_t i = 0;
-    while (i < capacity && i < other.capacity) {
-        array[i] = array[i] & other.array[i];
-        ++i;
+bigint bigint_mod_context::residue::value() const {
+    const size_t n = ctx->n;
+    if (!ctx->m_inv) return bigint::from_limbs(limbs.array, n);
+
+    bigint& t = modular_scratch;
+    t.reserve(2 * n + 1);
+    for (size_t i = 0; i < n; i++) {
+        t.array[i] = limbs.array[i];
     }
-    while (i < capacity) {
-        array[i] = 0;
-        ++i;
+    for (size_t i = n; i <= 2 * n; i++) {
+        t.array[i] = 0;
     }
+    bigint result;
+    result.reserve(n);
+    redc(result.array, t.array, ctx->m.array, n, ctx->m_inv);
+    result.trim();
+    return result;
+}
+
+bigint_mod_context::residue& bigint_mod_context::residue::operator+=(const residue& rhs) {
+    ctx->check(*this, rhs);
+    ctx->add(limbs, limbs, rhs.limbs);
     return *this;
 }
 
-bigint& bigint::operator |= (const bigint& other) {
-    size_t i = 0;
-    while (i < capacity || i < other.capacity) {
-        const byte lbyte = (i < capacity) ? array[i] : 0;
-        const byte rbyte = (i < other.capacity) ? other.array[i] : 0;
-        if (i == capacity) grow();
-        array[i] = lbyte | rbyte;
-        ++i;
-    }
+bigint_mod_context::residue& bigint_mod_context::residue::operator-=(const residue& rhs) {
+    ctx->check(*this, rhs);
+    ctx->sub(limbs, limbs, rhs.limbs);
     return *this;
 }
 
-bigint& bigint::operator ^= (const bigint& other) {
-    size_t i = 0;
-    while (i < capacity || i < other.capacity) {
-        const byte lbyte = (i < capacity) ? array[i] : 0;
-        const byte rbyte = (i < other.capacity) ? other.array[i] : 0;
-        if (i == capacity) grow();
-        array[i] = lbyte ^ rbyte;
-        ++i;
-    }
+bigint_mod_context::residue& bigint_mod_context::residue::operator*=(const residue& rhs) {
+    ctx->check(*this, rhs);
+    ctx->mul(limbs, limbs, rhs.limbs);
     return *this;
 }
 
-bigint& bigint::operator <<= (size_t other) {
-    return this->operator=(std::move(this->operator<<(other)));
+bigint_mod_context::residue bigint_mod_context::residue::operator-() const {
+    residue r(ctx, bigint());
+    ctx->sub(r.limbs, r.limbs, limbs);
+    return r;
 }
 
-bigint& bigint::operator >>= (size_t other) {
-    return this->operator=(std::move(this->operator>>(other)));
+bool bigint_mod_context::residue::operator==(const residue& rhs) const {
+    ctx->check(*this, rhs);
+    return cmp(limbs.array, ctx->n, rhs.limbs.array, ctx->n) == 0;
 }
 
-// MARK: std::string Conversion
+// MARK: Views
 
-std::string bigint::to_string() const {
-    bigint cpy = *this;
-    cpy.is_negative = false;
+bigint_view::bigint_view(const uint64_t* limbs, size_t n, bool negative)
+    :limbs(limbs), n(n), negative(negative) {
+    while (this->n && !limbs[this->n - 1]) --this->n;
+    if (!this->n) this->negative = false;
+}
 
-    std::string result_rev;
-    const bigint base = 10;
-    do {
-        char digit = cpy % base;
-        digit += 48;
-        result_rev.push_back(digit);
-        cpy /= base;
-    } while (cpy != zero);
-    if (is_negative && cpy != zero) result_rev.push_back('-');
+bigint_view::bigint_view(const bigint& x)
+    :limbs(x.array), n(x.num_limbs()), negative(x.is_negative) {}
 
-    std::string result;
-    for (auto it = result_rev.end(); it-- != result_rev.begin(); ) {
-        result.push_back(*it);
-    }
+bigint_view::operator bigint() const {
+    bigint result = bigint::from_limbs(limbs, n);
+    result.is_negative = negative;
     return result;
 }
 
-std::string bigint::to_hex(bool print_leading_zeros) const {
-    std::string result = is_negative ? "-0x" : "0x";
-    const char hex_table[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-    bool started = false;
-    for (size_t i = capacity; i-- > 0; ) {
-        if (array[i] >> 4) started = true;
-        if (started || print_leading_zeros) result.push_back(hex_table[array[i] >> 4]);
-        if (array[i] & 0xF) started = true;
-        if (started || print_leading_zeros) result.push_back(hex_table[array[i] & 0xF]);
-    }
-    if (result.back() == 'x') result.push_back('0');
+int bigint_view::compare(const bigint_view& rhs) const {
+    if (negative != rhs.negative) return negative ? -1 : 1;
+    const int c = cmp(limbs, n, rhs.limbs, rhs.n);
+    return negative ? -c : c;
+}
 
+bigint bigint_view::add(const bigint_view& lhs, const bigint_view& rhs, bool negate) {
+    bigint result;
+    bigint::signed_add(result, lhs.limbs, lhs.n, lhs.negative, rhs.limbs, rhs.n, rhs.negative != negate);
     return result;
 }
 
-std::string bigint::to_bin(bool print_leading_zeros) const {
-    std::string result = is_negative ? "-" : "";
-
-    bool started = false;
-    for (size_t i = capacity; i-- > 0; ) {
-        for (unsigned int j = 8; j-- > 0; ) {
-            bool is_on = (array[i] >> j) & 0x1;
-            if (is_on) started = true;
-            if (started || print_leading_zeros) result.push_back(is_on ? '1' : '0');
-        }
-    }
-
-    if (result.empty() || result.back() == '-') result.push_back('0');
+bigint bigint_view::multiply(const bigint_view& lhs, const bigint_view& rhs) {
+    const operation_scope scope(bigint::operation::multiply);
+    bigint result;
+    if (!lhs.n || !rhs.n) return result;
+    result.reserve(lhs.n + rhs.n);
+    bigint::mul_limbs(result.array, lhs.limbs, lhs.n, rhs.limbs, rhs.n);
+    result.is_negative = lhs.negative != rhs.negative;
+    result.trim();
     return result;
 }
 
-// MARK: Static Functions
+// MARK: Streaming Input
 
-bigint bigint::pow(const bigint& base, const bigint& exp) {
-    if (exp < 0) return zero;
+bigint_parser::bigint_parser()
+    :negative(false), started(false) {}
 
-    bigint b = base;
-    bigint e = exp;
-    bigint result = 1;
-    while (e > 0) {
-        unsigned char byte = e & bigint(0xFFu);
-        for (int i = 0; i < 8; i++) {
-            bool is_on = byte & (1 << i);
-            if (is_on) result *= b;
-            b *= b;
+void bigint_parser::feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        const char c = data[i];
+        if (!started && (c == '-' || c == '+')) {
+            negative = c == '-';
+        } else if (c >= '0' && c <= '9') {
+            pending.push_back(c);
+            if (pending.size() == chunk_digits) flush();
+        } else {
+            throw std::invalid_argument("Invalid decimal digit.");
         }
-        e >>= 8;
+        started = true;
     }
-    return result;
 }
 
-bigint bigint::factorial(const bigint& n) {
-    if (n < 0) throw std::invalid_argument("Cannot take factorial of negative number.");
-
-    bigint result = 1;
-    for (bigint i = 1; i <= n; i++) {
-        result *= i;
+const bigint& bigint_parser::power(size_t level, bigint& tmp) {
+    // 10^(chunk_digits * 2^level), the length of a part at that level. Levels
+    // below the two highest held are needed over and over and are kept. The
+    // others are needed once per doubling of the input, so rather than sit
+    // next to the value they are squared up into tmp, which the caller frees.
+    const size_t top = parts.empty() ? 0 : parts.front().level;
+    const size_t keep = top > 1 ? top - 1 : 1;
+    while (powers.size() < std::min(level + 1, keep)) {
+        powers.push_back(powers.empty() ? bigint::pow(10, chunk_digits) : powers.back() * powers.back());
     }
+    if (level < powers.size()) return powers[level];
+    tmp = powers.back() * powers.back();
+    for (size_t i = powers.size() + 1; i <= level; i++) {
+        tmp *= tmp;
+    }
+    return tmp;
+}
+
+void bigint_parser::flush() {
+    // Converts a full chunk and carries it up: two parts at level j make one
+    // at level j + 1 as high * 10^(chunk_digits * 2^j) + low.
+    bigint value = bigint::from_digits(pending.data(), pending.size(), 10);
+    pending.clear();
+    size_t level = 0;
+    while (!parts.empty() && parts.back().level == level) {
+        bigint tmp;
+        const bigint& scale = power(level, tmp);
+        bigint high = std::move(parts.back().value);
+        parts.pop_back();
+        bigint::multiply_into(high, high, scale);
+        value += high;
+        ++level;
+    }
+    parts.push_back({std::move(value), level});
+}
+
+bigint bigint_parser::finish() {
+    if (parts.empty() && pending.empty()) throw std::invalid_argument("Input did not contain a number.");
+
+    // The parts still held have distinct levels, highest first. They and the
+    // partial chunk are combined from the low end up, and each part is freed
+    // once it has been used, along with the powers the higher parts do not
+    // need. The highest cached power stays, as the ones above it are squared
+    // up from it.
+    size_t digits = pending.size();
+    bigint result = bigint::from_digits(pending.data(), pending.size(), 10);
+    pending.clear();
+    bigint scale = bigint::pow(10, digits);
+    while (!parts.empty()) {
+        part& p = parts.back();
+        result += p.value * scale;
+        if (parts.size() > 1) {
+            bigint tmp;
+            scale *= power(p.level, tmp);
+        }
+        for (size_t i = 0; i <= p.level && i + 1 < powers.size(); i++) {
+            powers[i] = bigint();
+        }
+        parts.pop_back();
+    }
+    powers.clear();
+    if (negative) result = -result;
+    negative = started = false;
     return result;
 }
 
 // MARK: Non-Class Functions
 
 std::ostream& operator << (std::ostream& os, const bigint& num) {
-    return os << num.to_string();
+    // Plain decimal streams its digits. A field width needs the length up
+    // front, and the other formats are built from to_string, to_hex and
+    // to_bin, so only then is the whole string built.
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::ios_base::fmtflags base = flags & std::ios_base::basefield;
+    const bool hex = base == std::ios_base::hex, oct = base == std::ios_base::oct;
+    if (!os.width() && !hex && !oct && !(flags & std::ios_base::showpos)) {
+        num.write_decimal(os);
+        return os;
+    }
+
+    // Like the built-in integers, nonzero values in hex and oct take an 0x or
+    // 0 prefix under showbase, hex digits follow uppercase, and showpos marks
+    // positive values in decimal. Negative values print as a sign and
+    // magnitude in every base.
+    std::string prefix = num < 0 ? "-" : (!hex && !oct && (flags & std::ios_base::showpos)) ? "+" : "";
+    std::string digits;
+    if (hex) {
+        digits = num.to_hex();
+        digits.erase(0, digits.find('x') + 1);
+        if (flags & std::ios_base::uppercase) {
+            for (char& c : digits) {
+                if (c >= 'a') c = static_cast<char>(c - 'a' + 'A');
+            }
+        }
+        if ((flags & std::ios_base::showbase) && num != 0) prefix += (flags & std::ios_base::uppercase) ? "0X" : "0x";
+    } else if (oct) {
+        const std::string bits = num.to_bin();
+        const size_t start = num < 0 ? 1 : 0;
+        const size_t n = bits.size() - start;
+        size_t i = start;
+        unsigned int d = 0;
+        for (size_t left = n; left > 0; left--) {
+            d = 2 * d + (bits[i++] - '0');
+            if ((left - 1) % 3 == 0) {
+                digits.push_back(static_cast<char>('0' + d));
+                d = 0;
+            }
+        }
+        // The octal base is a leading digit, so internal padding goes before it.
+        if ((flags & std::ios_base::showbase) && num != 0) digits.insert(0, 1, '0');
+    } else {
+        digits = num.to_string();
+        if (num < 0) digits.erase(0, 1);
+    }
+
+    // internal puts the fill between the sign or base and the digits.
+    const std::streamsize width = os.width();
+    const size_t length = prefix.size() + digits.size();
+    if ((flags & std::ios_base::adjustfield) == std::ios_base::internal && width > 0 && static_cast<size_t>(width) > length) {
+        prefix.append(static_cast<size_t>(width) - length, os.fill());
+        os.width(0);
+    }
+    return os << (prefix + digits);
 }
 
 std::istream& operator >> (std::istream& is, bigint& num) {
-    std::string input;
-    is >> input;
-    try {
-        num = stobi(input, nullptr, 10);
-    } catch (const std::invalid_argument& err) {
+    // Reads an optional sign and the digits that follow, leaving the first
+    // non-digit in the stream as the built-in extractors do. Digits go to a
+    // bigint_parser a block at a time.
+    const std::istream::sentry ok(is);
+    if (!ok) return is;
+    std::streambuf* buf = is.rdbuf();
+    bigint_parser parser;
+    char block[4096];
+    size_t used = 0;
+    bool digits = false;
+    int c = buf->sgetc();
+    if (c == '-' || c == '+') {
+        block[used++] = static_cast<char>(c);
+        c = buf->snextc();
+    }
+    for (; c != std::char_traits<char>::eof() && c >= '0' && c <= '9'; c = buf->snextc()) {
+        digits = true;
+        block[used++] = static_cast<char>(c);
+        if (used == sizeof(block)) {
+            parser.feed(block, used);
+            used = 0;
+        }
+    }
+    if (!digits) {
+        // A sign alone is not a number, so it goes back for the next read.
+        if (used) c = buf->sungetc();
+        if (c == std::char_traits<char>::eof()) is.setstate(std::ios_base::eofbit);
         is.setstate(std::ios_base::failbit);
+        return is;
     }
+    if (c == std::char_traits<char>::eof()) is.setstate(std::ios_base::eofbit);
+    parser.feed(block, used);
+    num = parser.finish();
     return is;
 }
 
 bigint stobi(const std::string& str, size_t* pos, int base) {
-    auto it = str.begin();
-    while (it != str.end() && std::isspace(*it)) ++it;
+    return stobi(str.data(), str.size(), pos, base);
+}
+
+bigint stobi(const char* str, size_t len, size_t* pos, int base) {
+    const operation_scope scope(bigint::operation::convert);
+    const char* const end = str + len;
+    const char* it = str;
+    while (it != end && std::isspace(*it)) ++it;
 
-    bigint result;
     bool negative = false;
-    if (it != str.end() && *it == '-') {
+    if (it != end && *it == '-') {
         negative = true;
         ++it;
-    } else if (it != str.end() && *it == '+') {
+    } else if (it != end && *it == '+') {
         ++it;
     }
 
     bool number = false;
+    const char* digits = end;
 
-    while (it != str.end()) {
+    while (it != end) {
         int digit;
         if (*it == '0') {
             if (!number) {
                 number = true;
                 ++it;
-                if (it != str.end()) {
+                if (it != end) {
                     if (*it == 'x') {
                         if (base == 0) base = 16;
                         if (base == 16) {
@@ -966,18 +3817,19 @@ bigint stobi(const std::string& str, size_t* pos, int base) {
         else if (*it >= 'A' && *it <= 'Z') digit = *it - 'A' + 10;
         else if (*it >= 'a' && *it <= 'z') digit = *it - 'a' + 10;
         else break;
+        if (base == 0) base = 10;
         if (digit >= base) break;
 
-        if (!number) {
-            if (base == 0) base = 10;
-            number = true;
-        }
-        result *= base;
-        result += digit;
+        number = true;
+        if (digits == end) digits = it;
         ++it;
     }
     if (!number) throw std::invalid_argument("std::string did not contain a number.");
-    if (pos) *pos = it - str.begin();
+    if (pos) *pos = it - str;
+
+    bigint result;
+    if (digits != end) result = bigint::from_digits(digits, it - digits, base);
+    if constexpr (stats_enabled) count_size(convert_sizes_at, result.num_limbs());
     if (negative) result = -result;
     return result;
-}
\ No newline at end of file
+}
@@ -1,25 +1,217 @@
 #ifndef BIGINT_H
 #define BIGINT_H
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <limits>
+#include <memory_resource>
+#include <type_traits>
 #include <iostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+#ifdef __cpp_impl_three_way_comparison
+#include <compare>
+#endif
+
+#ifndef BIGINT_KARATSUBA_THRESHOLD
+#define BIGINT_KARATSUBA_THRESHOLD 24
+#endif
+#ifndef BIGINT_TOOM3_THRESHOLD
+#define BIGINT_TOOM3_THRESHOLD 512
+#endif
+#ifndef BIGINT_TOOM4_THRESHOLD
+#define BIGINT_TOOM4_THRESHOLD 2048
+#endif
+#ifndef BIGINT_FFT_THRESHOLD
+#define BIGINT_FFT_THRESHOLD 8192
+#endif
+#ifndef BIGINT_NEWTON_THRESHOLD
+#define BIGINT_NEWTON_THRESHOLD 2048
+#endif
+#ifndef BIGINT_HGCD_THRESHOLD
+#define BIGINT_HGCD_THRESHOLD 256
+#endif
+#ifndef BIGINT_THREADS
+#define BIGINT_THREADS 1
+#endif
+#ifndef BIGINT_PARALLEL_THRESHOLD
+#define BIGINT_PARALLEL_THRESHOLD 2048
+#endif
+#ifndef BIGINT_STATS
+#define BIGINT_STATS 0
+#endif
 
 class bigint {
-    using byte = uint8_t;
-    using dbyte = uint16_t;
+    using limb = uint64_t;
+    using dlimb = unsigned __int128;
     private:
+        static constexpr size_t inline_limbs = 2;
+        static constexpr size_t to_string_threshold = 32;
+        static constexpr size_t from_digits_threshold = 32;
+
+        // The limbs in use, up to the highest nonzero one. Code that writes limbs
+        // directly calls normalize() (or trim()) before anything reads it.
         size_t capacity;
-        byte* array;
+        size_t limb_count;
+        limb* array;
         bool is_negative;
+        limb local[inline_limbs];
+        std::pmr::memory_resource* resource;
+
+        limb* allocate(size_t);
+        void deallocate(limb*, size_t);
 
         void grow();
+        void reserve(size_t);
+        bool remap(size_t);
         void trim();
-        size_t num_bytes() const;
+        void normalize(size_t);
+        size_t num_limbs() const;
+        size_t bit_length() const;
+        limb div_limb(limb);
+
+        static bigint from_limbs(const limb*, size_t);
+        static void signed_add(bigint&, const bigint&, bool, const bigint&, bool);
+        static void signed_add(bigint&, const limb*, size_t, bool, const limb*, size_t, bool);
+        static void multiply_into(bigint&, const bigint&, const bigint&);
+        static void fused_multiply_add(bigint&, const bigint&, const bigint&, bool);
+        static void divide(const bigint&, const bigint&, bigint*, bigint*);
+        static void divide_knuth(const bigint&, const bigint&, bigint&, bigint&);
+        static void divide_newton(const bigint&, const bigint&, const bigint&, bigint&, bigint&);
+        static bigint newton_reciprocal(const bigint&);
+
+        static void mul_limbs(limb*, const limb*, size_t, const limb*, size_t);
+        static void mul_basecase(limb*, const limb*, size_t, const limb*, size_t);
+        static void mul_karatsuba(limb*, const limb*, size_t, const limb*, size_t);
+        static void mul_toom3(limb*, const limb*, size_t, const limb*, size_t);
+        static void mul_toom4(limb*, const limb*, size_t, const limb*, size_t);
+        static void mul_ntt(limb*, const limb*, size_t, const limb*, size_t);
+        static void multiply_all(bigint* const*, const bigint* const*, const bigint* const*, size_t, size_t);
+        static void toom_split(const limb*, size_t, size_t, bigint*, size_t);
+        static void toom_recompose(limb*, size_t, size_t, const bigint*, size_t);
+
+        static bool gcd_step(bigint&, bigint&, size_t, bigint*);
+        static bool lehmer_step(bigint&, bigint&, size_t, bigint*);
+        static bool hgcd(bigint&, bigint&, size_t, bigint*);
+        static void gcd_reduce(bigint&, bigint&, bigint*);
+
+        static size_t decimal_level(size_t);
+        static void to_decimal(const std::function<void(const char*, size_t)>&, const bigint&, size_t, bool);
+        static bigint from_digits(const char*, size_t, int);
+
+        friend bigint stobi(const char*, size_t, size_t*, int);
+        friend class bigint_parser;
+        friend class bigint_mod_context;
+        friend class bigint_view;
+        template<size_t, bool> friend class fixed_bigint;
     public:
+        // Operand sizes, in 64-bit limbs, at which multiplication switches to the
+        // next algorithm, at which division switches to Newton's method once
+        // both the divisor and the quotient reach it, and at which gcd switches
+        // from Lehmer's algorithm to the half-gcd. Defaults come from the
+        // BIGINT_*_THRESHOLD macros. A multiplication whose smaller operand reaches
+        // parallel_threshold spreads its subproducts and transforms over up to
+        // threads threads, counting the caller (BIGINT_THREADS, 1 by default).
+        // Change threads only while no multiplication is running.
+        struct tuning_parameters {
+            size_t karatsuba_threshold;
+            size_t toom3_threshold;
+            size_t toom4_threshold;
+            size_t fft_threshold;
+            size_t newton_threshold;
+            size_t threads;
+            size_t parallel_threshold;
+            size_t hgcd_threshold;
+        };
+
+        // Instrumentation, compiled in only when BIGINT_STATS is nonzero (stats()
+        // is all zeros otherwise). Calls and heap allocations are charged to the
+        // outermost operation running on the thread, so a pow's multiplications
+        // count as power; allocations by helper threads count as other. The
+        // histograms count multiplications, divisions and conversions by the larger
+        // operand's limb count n, in bucket 0 for n = 0 and bucket i for
+        // 2^(i-1) <= n < 2^i. Tier times cover the outermost multiplication and
+        // division on each thread (divisions include their multiplications).
+        // Multiplications and divisions whose smaller operand is below the
+        // Karatsuba threshold are counted but not timed.
+        enum class operation {
+            add,
+            multiply,
+            divide,
+            shift,
+            bitwise,
+            convert,
+            power,
+            gcd,
+            other
+        };
+        enum class tier {
+            basecase,
+            unbalanced,
+            karatsuba,
+            toom3,
+            toom4,
+            ntt,
+            knuth,
+            newton
+        };
+        struct statistics {
+            static constexpr size_t operations = 9;
+            static constexpr size_t tiers = 8;
+            static constexpr size_t buckets = 40;
+
+            uint64_t calls[operations];
+            uint64_t allocations[operations];
+            uint64_t allocated_bytes[operations];
+            uint64_t reallocations;      // reserve moving existing limbs to new storage
+            uint64_t reallocated_bytes;
+            uint64_t trims;              // trim moving limbs to smaller storage
+            uint64_t trimmed_bytes;
+            uint64_t multiply_sizes[buckets];
+            uint64_t divide_sizes[buckets];
+            uint64_t convert_sizes[buckets];
+            uint64_t tier_calls[tiers];
+            uint64_t tier_ns[tiers];
+        };
+
+        // Rounding of the quotient in divmod. truncate matches operator/ and
+        // operator%; floor rounds toward negative infinity, so the remainder takes
+        // the sign of the divisor.
+        enum class rounding {
+            truncate,
+            floor
+        };
+
+        // Opt-in expression templates. Starting from bigint::lazy(x), the operators
+        // + - * << >> build an expression tree instead of temporaries, and assigning
+        // the tree to a bigint evaluates it in place. Products that are added or
+        // subtracted go through a fused multiply-accumulate kernel.
+        template<typename E> class expression;
+        class ref_expr;
+        template<char Op, typename L, typename R> class binary_expr;
+        template<bool Left, typename E> class shift_expr;
+
         static const bigint zero;
+        static tuning_parameters tuning;
+
+        static ref_expr lazy(const bigint&);
+
+        // Heap storage comes from a std::pmr::memory_resource. Objects built
+        // without one use the calling thread's default, which is std::pmr's
+        // default unless set_default_resource has changed it (null restores it).
+        // As with the std::pmr containers, moves keep the source's resource,
+        // copies take the default, and assignment never changes the resource.
+        static std::pmr::memory_resource* default_resource();
+        static void set_default_resource(std::pmr::memory_resource*);
+        std::pmr::memory_resource* get_resource() const;
+
+        // A snapshot of the counters since startup or the last reset_stats().
+        static statistics stats();
+        static void reset_stats();
 
         bigint();
         bigint(char);
@@ -34,12 +226,20 @@ class bigint {
         bigint(unsigned long);
         bigint(unsigned long long);
 
+        explicit bigint(std::pmr::memory_resource*);
+        bigint(const bigint&, std::pmr::memory_resource*);
+
         bigint(const bigint&);
-        bigint(bigint&&);
+        bigint(bigint&&) noexcept;
         ~bigint();
         bigint& operator=(const bigint&);
         bigint& operator=(bigint&&);
 
+        template<typename E> bigint(const expression<E>&);
+        template<typename E> bigint& operator=(const expression<E>&);
+        template<typename E> bigint& operator+=(const expression<E>&);
+        template<typename E> bigint& operator-=(const expression<E>&);
+
         operator bool() const;
         operator char() const;
         operator short() const;
@@ -60,29 +260,38 @@ class bigint {
         bigint operator++(int);
         bigint operator--(int);
 
+        // The sign of *this - rhs, and of |*this| - |rhs|, as -1, 0 or 1. Both
+        // decide from the signs and lengths where they can and never allocate.
+        int compare(const bigint&) const;
+        int compare_abs(const bigint&) const;
+
         bool operator==(const bigint&) const;
         bool operator!=(const bigint&) const;
         bool operator>(const bigint&) const;
         bool operator<(const bigint&) const;
         bool operator>=(const bigint&) const;
         bool operator<=(const bigint&) const;
-        template<typename T> bool operator==(T rhs) const {return this->operator==(static_cast<bigint>(rhs));}
-        template<typename T> bool operator!=(T rhs) const {return this->operator!=(static_cast<bigint>(rhs));}
-        template<typename T> bool operator<(T rhs) const {return this->operator<(static_cast<bigint>(rhs));}
-        template<typename T> bool operator>(T rhs) const {return this->operator>(static_cast<bigint>(rhs));}
-        template<typename T> bool operator<=(T rhs) const {return this->operator<=(static_cast<bigint>(rhs));}
-        template<typename T> bool operator>=(T rhs) const {return this->operator>=(static_cast<bigint>(rhs));}
+#ifdef __cpp_impl_three_way_comparison
+        std::strong_ordering operator<=>(const bigint& rhs) const {return compare(rhs) <=> 0;}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> std::strong_ordering operator<=>(T rhs) const {return compare(static_cast<bigint>(rhs)) <=> 0;}
+#endif
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator==(T rhs) const {return this->operator==(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator!=(T rhs) const {return this->operator!=(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator<(T rhs) const {return this->operator<(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator>(T rhs) const {return this->operator>(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator<=(T rhs) const {return this->operator<=(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator>=(T rhs) const {return this->operator>=(static_cast<bigint>(rhs));}
 
         bigint operator+(const bigint&) const;
         bigint operator-(const bigint&) const;
         bigint operator*(const bigint&) const;
         bigint operator/(const bigint&) const;
         bigint operator%(const bigint&) const;
-        template<typename T> bool operator+(T rhs) const {return this->operator+(static_cast<bigint>(rhs));}
-        template<typename T> bool operator-(T rhs) const {return this->operator-(static_cast<bigint>(rhs));}
-        template<typename T> bool operator*(T rhs) const {return this->operator*(static_cast<bigint>(rhs));}
-        template<typename T> bool operator/(T rhs) const {return this->operator/(static_cast<bigint>(rhs));}
-        template<typename T> bool operator%(T rhs) const {return this->operator%(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator+(T rhs) const {return this->operator+(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator-(T rhs) const {return this->operator-(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator*(T rhs) const {return this->operator*(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator/(T rhs) const {return this->operator/(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator%(T rhs) const {return this->operator%(static_cast<bigint>(rhs));}
 
         bigint& operator+=(const bigint&);
         bigint& operator-=(const bigint&);
@@ -95,9 +304,11 @@ class bigint {
         bigint operator^(const bigint&) const;
         bigint operator<<(size_t) const;
         bigint operator>>(size_t) const;
-        template<typename T> bool operator&(T rhs) const {return this->operator&(static_cast<bigint>(rhs));}
-        template<typename T> bool operator|(T rhs) const {return this->operator|(static_cast<bigint>(rhs));}
-        template<typename T> bool operator^(T rhs) const {return this->operator^(static_cast<bigint>(rhs));}
+        template<typename T> bigint operator<<(T rhs) const {return this->operator<<(static_cast<size_t>(rhs));}
+        template<typename T> bigint operator>>(T rhs) const {return this->operator>>(static_cast<size_t>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator&(T rhs) const {return this->operator&(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator|(T rhs) const {return this->operator|(static_cast<bigint>(rhs));}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator^(T rhs) const {return this->operator^(static_cast<bigint>(rhs));}
 
         bigint& operator&=(const bigint&);
         bigint& operator|=(const bigint&);
@@ -109,30 +320,731 @@ class bigint {
         std::string to_hex(bool = false) const;
         std::string to_bin(bool = false) const;
 
+        // Decimal output handed over in blocks of digits as they are produced, so
+        // the whole string never has to exist at once.
+        using digit_sink = std::function<void(const char*, size_t)>;
+        void write_decimal(const digit_sink&) const;
+        void write_decimal(std::ostream&) const;
+
+        // Binary conversion of the magnitude, like GMP's mpz_import and
+        // mpz_export: count words of word_size bytes, most significant word first
+        // if word_order is big, each word's bytes in byte_order. export_size is the
+        // number of words export_bytes writes; it throws std::length_error if
+        // count is smaller, and returns the number written.
+        enum class endian {
+            little,
+            big,
+            native
+        };
+        static bigint import_bytes(const void*, size_t, size_t, endian = endian::little, endian = endian::native);
+        size_t export_size(size_t) const;
+        size_t export_bytes(void*, size_t, size_t, endian = endian::little, endian = endian::native) const;
+
+        static std::pair<bigint, bigint> divmod(const bigint&, const bigint&, rounding = rounding::truncate);
         static bigint pow(const bigint&, const bigint&);
+        static bigint powmod(const bigint&, const bigint&, const bigint&);
+        static bigint mul_fft(const bigint&, const bigint&);
+
+        // gcd is never negative. gcdext returns (g, s, t) with a * s + b * t = g,
+        // and invert returns the inverse of a modulo |m| in [0, |m|), throwing if
+        // gcd(a, m) is not 1.
+        static bigint gcd(const bigint&, const bigint&);
+        static std::tuple<bigint, bigint, bigint> gcdext(const bigint&, const bigint&);
+        static bigint invert(const bigint&, const bigint&);
+
+        // Roots round toward zero, so odd roots of negative numbers are allowed,
+        // and the remainder is n - r^k. is_perfect_power tests for n = r^k with
+        // k >= 2, counting 0, 1 and -1.
+        static bigint isqrt(const bigint&);
+        static std::pair<bigint, bigint> sqrtrem(const bigint&);
+        static bigint iroot(const bigint&, uint64_t);
+        static std::pair<bigint, bigint> rootrem(const bigint&, uint64_t);
+        static bool is_square(const bigint&);
+        static bool is_perfect_power(const bigint&);
+
+        // acc += a * b and acc -= a * b without a temporary for the product when
+        // b is small or a single limb.
+        static void addmul(bigint&, const bigint&, const bigint&);
+        static void submul(bigint&, const bigint&, const bigint&);
+        static void addmul(bigint&, const bigint&, uint64_t);
+        static void submul(bigint&, const bigint&, uint64_t);
         static bigint factorial(const bigint&);
+        static bigint double_factorial(const bigint&);
+        static bigint binomial(const bigint&, const bigint&);
+};
+
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator==(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) == rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator!=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) != rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator<(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) < rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator>(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) > rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator<=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) <= rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bool operator>=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) >= rhs;}
+
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator+(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) + rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator-(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) - rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator*(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) * rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator/(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) / rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator%(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) % rhs;}
+
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator&(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) & rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator|(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) | rhs;}
+template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> bigint operator^(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) ^ rhs;}
+
+template<typename E> class bigint::expression {
+    public:
+        const E& self() const {return static_cast<const E&>(*this);}
+        // The value of the expression, evaluated into tmp unless a bigint already holds it.
+        const bigint& value(bigint& tmp) const {self().eval(tmp); return tmp;}
+};
+
+class bigint::ref_expr : public bigint::expression<bigint::ref_expr> {
+    private:
+        const bigint* ptr;
+    public:
+        explicit ref_expr(const bigint& x) : ptr(&x) {}
+        bool aliases(const bigint* p) const {return ptr == p;}
+        const bigint& value(bigint&) const {return *ptr;}
+        void eval(bigint& dest) const {dest = *ptr;}
+        void accumulate(bigint& dest, bool negate) const {signed_add(dest, dest, dest.is_negative, *ptr, ptr->is_negative != negate);}
+};
+
+template<char Op, typename L, typename R> class bigint::binary_expr : public bigint::expression<bigint::binary_expr<Op, L, R>> {
+    private:
+        L lhs;
+        R rhs;
+    public:
+        binary_expr(const L& l, const R& r) : lhs(l), rhs(r) {}
+        bool aliases(const bigint* p) const {return lhs.aliases(p) || rhs.aliases(p);}
+        void eval(bigint& dest) const {
+            if (Op == '*') {
+                bigint ltmp, rtmp;
+                multiply_into(dest, lhs.value(ltmp), rhs.value(rtmp));
+            } else {
+                lhs.eval(dest);
+                rhs.accumulate(dest, Op == '-');
+            }
+        }
+        void accumulate(bigint& dest, bool negate) const {
+            if (Op == '*') {
+                bigint ltmp, rtmp;
+                fused_multiply_add(dest, lhs.value(ltmp), rhs.value(rtmp), negate);
+            } else {
+                lhs.accumulate(dest, negate);
+                rhs.accumulate(dest, negate != (Op == '-'));
+            }
+        }
+};
+
+template<bool Left, typename E> class bigint::shift_expr : public bigint::expression<bigint::shift_expr<Left, E>> {
+    private:
+        E operand;
+        size_t shamt;
+    public:
+        shift_expr(const E& e, size_t s) : operand(e), shamt(s) {}
+        bool aliases(const bigint* p) const {return operand.aliases(p);}
+        void eval(bigint& dest) const {
+            operand.eval(dest);
+            if (Left) dest <<= shamt;
+            else dest >>= shamt;
+        }
+        void accumulate(bigint& dest, bool negate) const {
+            bigint tmp;
+            eval(tmp);
+            signed_add(dest, dest, dest.is_negative, tmp, tmp.is_negative != negate);
+        }
+};
+
+inline bigint::ref_expr bigint::lazy(const bigint& x) {return ref_expr(x);}
+
+template<typename E> bigint::bigint(const expression<E>& e) : bigint() {e.self().eval(*this);}
+
+template<typename E> bigint& bigint::operator=(const expression<E>& e) {
+    if (e.self().aliases(this)) return *this = bigint(e);
+    e.self().eval(*this);
+    return *this;
+}
+
+template<typename E> bigint& bigint::operator+=(const expression<E>& e) {
+    if (e.self().aliases(this)) return *this += bigint(e);
+    e.self().accumulate(*this, false);
+    return *this;
+}
+
+template<typename E> bigint& bigint::operator-=(const expression<E>& e) {
+    if (e.self().aliases(this)) return *this -= bigint(e);
+    e.self().accumulate(*this, true);
+    return *this;
+}
+template<typename L, typename R> bigint::binary_expr<'+', L, R> operator+(const bigint::expression<L>& lhs, const bigint::expression<R>& rhs) {return {lhs.self(), rhs.self()};}
+template<typename L> bigint::binary_expr<'+', L, bigint::ref_expr> operator+(const bigint::expression<L>& lhs, const bigint& rhs) {return {lhs.self(), bigint::lazy(rhs)};}
+template<typename R> bigint::binary_expr<'+', bigint::ref_expr, R> operator+(const bigint& lhs, const bigint::expression<R>& rhs) {return {bigint::lazy(lhs), rhs.self()};}
+template<typename L, typename R> bigint::binary_expr<'-', L, R> operator-(const bigint::expression<L>& lhs, const bigint::expression<R>& rhs) {return {lhs.self(), rhs.self()};}
+template<typename L> bigint::binary_expr<'-', L, bigint::ref_expr> operator-(const bigint::expression<L>& lhs, const bigint& rhs) {return {lhs.self(), bigint::lazy(rhs)};}
+template<typename R> bigint::binary_expr<'-', bigint::ref_expr, R> operator-(const bigint& lhs, const bigint::expression<R>& rhs) {return {bigint::lazy(lhs), rhs.self()};}
+template<typename L, typename R> bigint::binary_expr<'*', L, R> operator*(const bigint::expression<L>& lhs, const bigint::expression<R>& rhs) {return {lhs.self(), rhs.self()};}
+template<typename L> bigint::binary_expr<'*', L, bigint::ref_expr> operator*(const bigint::expression<L>& lhs, const bigint& rhs) {return {lhs.self(), bigint::lazy(rhs)};}
+template<typename R> bigint::binary_expr<'*', bigint::ref_expr, R> operator*(const bigint& lhs, const bigint::expression<R>& rhs) {return {bigint::lazy(lhs), rhs.self()};}
+template<typename E> bigint::shift_expr<true, E> operator<<(const bigint::expression<E>& lhs, size_t rhs) {return {lhs.self(), rhs};}
+template<typename E> bigint::shift_expr<false, E> operator>>(const bigint::expression<E>& lhs, size_t rhs) {return {lhs.self(), rhs};}
+
+// A read-only signed number over limbs the caller owns: little-endian 64-bit
+// limbs, as a bigint stores them. Comparisons, +, - and * work on the buffer
+// directly; / and % copy the operands first. A bigint converts to a view of
+// itself, so views also mix with bigints, and either must outlive its views.
+class bigint_view {
+    private:
+        const uint64_t* limbs;
+        size_t n;
+        bool negative;
+
+        static bigint add(const bigint_view&, const bigint_view&, bool);
+        static bigint multiply(const bigint_view&, const bigint_view&);
+    public:
+        bigint_view(const uint64_t*, size_t, bool = false);
+        bigint_view(const bigint&);
+
+        const uint64_t* data() const {return limbs;}
+        size_t size() const {return n;}
+        bool is_negative() const {return negative;}
+        explicit operator bigint() const;
+
+        int compare(const bigint_view&) const;
+        bigint_view operator-() const {bigint_view r = *this; r.negative = n && !negative; return r;}
+
+        friend bool operator==(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) == 0;}
+        friend bool operator!=(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) != 0;}
+        friend bool operator<(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) < 0;}
+        friend bool operator>(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) > 0;}
+        friend bool operator<=(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) <= 0;}
+        friend bool operator>=(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) >= 0;}
+#ifdef __cpp_impl_three_way_comparison
+        friend std::strong_ordering operator<=>(const bigint_view& lhs, const bigint_view& rhs) {return lhs.compare(rhs) <=> 0;}
+#endif
+
+        friend bigint operator+(const bigint_view& lhs, const bigint_view& rhs) {return add(lhs, rhs, false);}
+        friend bigint operator-(const bigint_view& lhs, const bigint_view& rhs) {return add(lhs, rhs, true);}
+        friend bigint operator*(const bigint_view& lhs, const bigint_view& rhs) {return multiply(lhs, rhs);}
+        friend bigint operator/(const bigint_view& lhs, const bigint_view& rhs) {return bigint(lhs) / bigint(rhs);}
+        friend bigint operator%(const bigint_view& lhs, const bigint_view& rhs) {return bigint(lhs) % bigint(rhs);}
+};
+
+// Parses a decimal number fed in pieces, such as blocks read from a stream or
+// windows of a memory-mapped file. Each full chunk of digits is converted as it
+// arrives, and converted parts of equal length are merged as in a binary
+// counter, so memory stays near the size of the value rather than the text.
+// A sign may lead the first piece; any other non-digit throws
+// std::invalid_argument, as does finish() without a digit.
+class bigint_parser {
+    private:
+        static constexpr size_t chunk_digits = 16384;
+
+        struct part {
+            bigint value;
+            size_t level;
+        };
+        std::vector<part> parts;
+        std::vector<bigint> powers;
+        std::string pending;
+        bool negative;
+        bool started;
+
+        const bigint& power(size_t, bigint&);
+        void flush();
+    public:
+        bigint_parser();
+
+        void feed(const char*, size_t);
+        bigint finish();
+};
+
+// A bump allocator: allocation carves from chunks that grow geometrically, and
+// deallocation is a no-op. release() frees everything at once, so every bigint
+// using the arena must be gone or no longer used by then.
+class bigint_arena : public std::pmr::memory_resource {
+    private:
+        struct chunk {
+            chunk* next;
+            size_t size;
+        };
+
+        std::pmr::memory_resource* upstream;
+        chunk* chunks;
+        char* cursor;
+        size_t remaining;
+        size_t next_size;
+        size_t allocated;
+
+        void* do_allocate(size_t, size_t) override;
+        void do_deallocate(void*, size_t, size_t) override;
+        bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+    public:
+        explicit bigint_arena(size_t = 64 * 1024, std::pmr::memory_resource* = std::pmr::new_delete_resource());
+        bigint_arena(const bigint_arena&) = delete;
+        bigint_arena& operator=(const bigint_arena&) = delete;
+        ~bigint_arena();
+
+        void release();
+        size_t bytes_allocated() const;
+};
+
+// Recycles blocks through per-thread free lists of power-of-two size classes, so
+// threads never contend on a shared heap for small and medium numbers. The
+// lists are per thread rather than per object, so all pools are
+// interchangeable. Blocks over 8 MiB go straight to operator new.
+class bigint_pool : public std::pmr::memory_resource {
+    private:
+        void* do_allocate(size_t, size_t) override;
+        void do_deallocate(void*, size_t, size_t) override;
+        bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+};
+
+// Backs blocks of at least threshold bytes with memory-mapped temporary files in
+// a directory (TMPDIR or /tmp by default), so numbers too large for memory page
+// out to disk rather than to swap; smaller blocks come from upstream. A bigint
+// using this resource grows and shrinks its mapped blocks with ftruncate and
+// mremap, so they are never copied, and multiplication keeps its large
+// scratch buffers here while it is the thread's default resource. Each mapped
+// block records its file in a header page, so the resource is thread-safe
+// whenever upstream is. The directory should be on a disk-backed file system;
+// on tmpfs the pages only move into swap.
+class bigint_mmap_resource : public std::pmr::memory_resource {
+    private:
+        std::string directory;
+        size_t threshold;
+        std::pmr::memory_resource* upstream;
+
+        bool mapped(size_t, size_t) const;
+        void* do_allocate(size_t, size_t) override;
+        void do_deallocate(void*, size_t, size_t) override;
+        bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+    public:
+        explicit bigint_mmap_resource(std::string = "", size_t = 1 << 20,
+                                      std::pmr::memory_resource* = std::pmr::new_delete_resource());
+
+        // Resizes a block from this resource, keeping its contents and
+        // returning where it now is, or returns null if either size is below
+        // the threshold, in which case the block is unchanged. Bytes past the
+        // old size read as zero unless they were written before a shrink.
+        void* reallocate(void*, size_t, size_t, size_t = alignof(std::max_align_t));
 };
 
-template<typename T> bool operator==(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) == rhs;}
-template<typename T> bool operator!=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) != rhs;}
-template<typename T> bool operator<(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) < rhs;}
-template<typename T> bool operator>(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) > rhs;}
-template<typename T> bool operator<=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) <= rhs;}
-template<typename T> bool operator>=(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) >= rhs;}
+// Precomputes the reduction constants for one modulus, so that chains of
+// modular arithmetic skip the full division of operator% at every step. Odd
+// moduli use Montgomery multiplication and even ones Barrett reduction.
+// Residues refer to their context, which must outlive them.
+class bigint_mod_context {
+    public:
+        class residue;
+    private:
+        bigint m;
+        size_t n;
+        uint64_t m_inv;
+        bigint r2;
+        bigint inv;
+
+        void mul(bigint&, const bigint&, const bigint&) const;
+        void add(bigint&, const bigint&, const bigint&) const;
+        void sub(bigint&, const bigint&, const bigint&) const;
+        void check(const residue&, const residue&) const;
+    public:
+        explicit bigint_mod_context(const bigint&);
+
+        const bigint& modulus() const;
+        residue operator()(const bigint&) const;
+        residue pow(const residue&, const bigint&) const;
+};
+
+// A value modulo a bigint_mod_context's modulus, held in n limbs in whatever
+// form the context reduces in. value() converts back to a bigint in [0, m).
+class bigint_mod_context::residue {
+    private:
+        const bigint_mod_context* ctx;
+        bigint limbs;
+
+        residue(const bigint_mod_context*, bigint);
+        friend class bigint_mod_context;
+    public:
+        // Copies and moves keep room for all n limbs, which the arithmetic
+        // reads whatever the value's length.
+        residue(const residue&);
+        residue(residue&&);
+        residue& operator=(const residue&);
+        residue& operator=(residue&&);
+
+        bigint value() const;
+        const bigint_mod_context& context() const {return *ctx;}
+
+        residue& operator+=(const residue&);
+        residue& operator-=(const residue&);
+        residue& operator*=(const residue&);
+
+        residue operator+(const residue& rhs) const {residue r = *this; return r += rhs;}
+        residue operator-(const residue& rhs) const {residue r = *this; return r -= rhs;}
+        residue operator*(const residue& rhs) const {residue r = *this; return r *= rhs;}
+        residue operator-() const;
+        residue pow(const bigint& exp) const {return ctx->pow(*this, exp);}
+
+        bool operator==(const residue&) const;
+        bool operator!=(const residue& rhs) const {return !(*this == rhs);}
+};
+
+// A two's-complement integer of a fixed width, with its limbs held inline.
+// Arithmetic wraps modulo 2^Bits like the built-in integer types, and
+// everything but the bigint and string conversions is constexpr. Loops run
+// over a compile-time number of limbs, so the compiler unrolls the carry
+// chains. Bits must be a positive multiple of 64.
+template<size_t Bits, bool Signed = false>
+class fixed_bigint {
+    using limb = uint64_t;
+    using dlimb = unsigned __int128;
+    static_assert(Bits && Bits % 64 == 0, "fixed_bigint width must be a positive multiple of 64 bits.");
+    public:
+        static constexpr size_t limbs = Bits / 64;
+    private:
+        limb array[limbs];
+
+        template<size_t, bool> friend class fixed_bigint;
+
+        constexpr bool negative() const {return Signed && (array[limbs - 1] >> 63);}
+        constexpr fixed_bigint magnitude() const {return negative() ? -*this : *this;}
+        static constexpr int compare(const fixed_bigint&, const fixed_bigint&);
+        static constexpr void divide(const fixed_bigint&, const fixed_bigint&, fixed_bigint*, fixed_bigint*);
+    public:
+        constexpr fixed_bigint() : array{} {}
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>> constexpr fixed_bigint(T value) : array{} {
+            array[0] = static_cast<limb>(value);
+            const limb fill = (std::is_signed<T>::value && value < 0) ? ~limb(0) : 0;
+            for (size_t i = 1; i < limbs; i++) {
+                array[i] = fill;
+            }
+        }
+        template<size_t B, bool S> explicit constexpr fixed_bigint(const fixed_bigint<B, S>& other) : array{} {
+            const limb fill = other.negative() ? ~limb(0) : 0;
+            for (size_t i = 0; i < limbs; i++) {
+                array[i] = (i < other.limbs) ? other.array[i] : fill;
+            }
+        }
+        explicit fixed_bigint(const bigint&);
+
+        explicit operator bigint() const;
+        explicit constexpr operator bool() const {
+            for (size_t i = 0; i < limbs; i++) {
+                if (array[i]) return true;
+            }
+            return false;
+        }
+        template<typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> explicit constexpr operator T() const {return static_cast<T>(array[0]);}
+
+        std::string to_string() const {return static_cast<bigint>(*this).to_string();}
+        std::string to_hex() const {return static_cast<bigint>(*this).to_hex();}
+        std::string to_bin() const {return static_cast<bigint>(*this).to_bin();}
+
+        constexpr fixed_bigint operator+() const {return *this;}
+        constexpr fixed_bigint operator-() const {
+            fixed_bigint result;
+            limb borrow = 1;
+            for (size_t i = 0; i < limbs; i++) {
+                result.array[i] = ~array[i] + borrow;
+                borrow = borrow && !result.array[i];
+            }
+            return result;
+        }
+        constexpr fixed_bigint operator~() const {
+            fixed_bigint result;
+            for (size_t i = 0; i < limbs; i++) {
+                result.array[i] = ~array[i];
+            }
+            return result;
+        }
+        constexpr fixed_bigint& operator++() {return *this += 1;}
+        constexpr fixed_bigint& operator--() {return *this -= 1;}
+        constexpr fixed_bigint operator++(int) {fixed_bigint old = *this; *this += 1; return old;}
+        constexpr fixed_bigint operator--(int) {fixed_bigint old = *this; *this -= 1; return old;}
+
+        constexpr fixed_bigint& operator+=(const fixed_bigint& rhs) {
+            limb carry = 0;
+            for (size_t i = 0; i < limbs; i++) {
+                const dlimb sum = static_cast<dlimb>(array[i]) + rhs.array[i] + carry;
+                array[i] = static_cast<limb>(sum);
+                carry = static_cast<limb>(sum >> 64);
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator-=(const fixed_bigint& rhs) {
+            limb borrow = 0;
+            for (size_t i = 0; i < limbs; i++) {
+                const dlimb diff = static_cast<dlimb>(array[i]) - rhs.array[i] - borrow;
+                array[i] = static_cast<limb>(diff);
+                borrow = static_cast<limb>(diff >> 64) & 0x1;
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator*=(const fixed_bigint& rhs) {
+            // Only the low limbs of the product are kept, which is the same for
+            // signed and unsigned operands.
+            limb r[limbs] = {};
+            for (size_t i = 0; i < limbs; i++) {
+                if (!array[i]) continue;
+                limb carry = 0;
+                for (size_t j = 0; i + j < limbs; j++) {
+                    const dlimb t = static_cast<dlimb>(array[i]) * rhs.array[j] + r[i + j] + carry;
+                    r[i + j] = static_cast<limb>(t);
+                    carry = static_cast<limb>(t >> 64);
+                }
+            }
+            for (size_t i = 0; i < limbs; i++) {
+                array[i] = r[i];
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator/=(const fixed_bigint& rhs) {
+            fixed_bigint q;
+            divide(magnitude(), rhs.magnitude(), &q, nullptr);
+            *this = (negative() != rhs.negative()) ? -q : q;
+            return *this;
+        }
+        constexpr fixed_bigint& operator%=(const fixed_bigint& rhs) {
+            fixed_bigint r;
+            divide(magnitude(), rhs.magnitude(), nullptr, &r);
+            *this = negative() ? -r : r;
+            return *this;
+        }
+        constexpr fixed_bigint& operator&=(const fixed_bigint& rhs) {
+            for (size_t i = 0; i < limbs; i++) {
+                array[i] &= rhs.array[i];
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator|=(const fixed_bigint& rhs) {
+            for (size_t i = 0; i < limbs; i++) {
+                array[i] |= rhs.array[i];
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator^=(const fixed_bigint& rhs) {
+            for (size_t i = 0; i < limbs; i++) {
+                array[i] ^= rhs.array[i];
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator<<=(size_t shift) {
+            const size_t offset = shift / 64;
+            const unsigned int bits = shift % 64;
+            for (size_t i = limbs; i-- > 0; ) {
+                limb x = 0;
+                if (shift < Bits && i >= offset) {
+                    x = array[i - offset] << bits;
+                    if (bits && i > offset) x |= array[i - offset - 1] >> (64 - bits);
+                }
+                array[i] = x;
+            }
+            return *this;
+        }
+        constexpr fixed_bigint& operator>>=(size_t shift) {
+            // Arithmetic for signed types, like the built-in ones.
+            const limb fill = negative() ? ~limb(0) : 0;
+            const size_t offset = (shift < Bits) ? shift / 64 : limbs;
+            const unsigned int bits = (shift < Bits) ? shift % 64 : 0;
+            for (size_t i = 0; i < limbs; i++) {
+                const limb lo = (i + offset < limbs) ? array[i + offset] : fill;
+                const limb hi = (i + offset + 1 < limbs) ? array[i + offset + 1] : fill;
+                array[i] = bits ? (lo >> bits) | (hi << (64 - bits)) : lo;
+            }
+            return *this;
+        }
+
+        friend constexpr fixed_bigint operator+(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs += rhs;}
+        friend constexpr fixed_bigint operator-(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs -= rhs;}
+        friend constexpr fixed_bigint operator*(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs *= rhs;}
+        friend constexpr fixed_bigint operator/(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs /= rhs;}
+        friend constexpr fixed_bigint operator%(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs %= rhs;}
+        friend constexpr fixed_bigint operator&(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs &= rhs;}
+        friend constexpr fixed_bigint operator|(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs |= rhs;}
+        friend constexpr fixed_bigint operator^(fixed_bigint lhs, const fixed_bigint& rhs) {return lhs ^= rhs;}
+        friend constexpr fixed_bigint operator<<(fixed_bigint lhs, size_t rhs) {return lhs <<= rhs;}
+        friend constexpr fixed_bigint operator>>(fixed_bigint lhs, size_t rhs) {return lhs >>= rhs;}
+
+        friend constexpr bool operator==(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) == 0;}
+        friend constexpr bool operator!=(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) != 0;}
+        friend constexpr bool operator<(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) < 0;}
+        friend constexpr bool operator>(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) > 0;}
+        friend constexpr bool operator<=(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) <= 0;}
+        friend constexpr bool operator>=(const fixed_bigint& lhs, const fixed_bigint& rhs) {return compare(lhs, rhs) >= 0;}
+
+        friend std::ostream& operator<<(std::ostream& os, const fixed_bigint& x) {return os << x.to_string();}
+};
+
+template<size_t Bits> using fixed_uint = fixed_bigint<Bits, false>;
+template<size_t Bits> using fixed_int = fixed_bigint<Bits, true>;
+
+template<size_t Bits, bool Signed> constexpr int fixed_bigint<Bits, Signed>::compare(const fixed_bigint& a, const fixed_bigint& b) {
+    if (a.negative() != b.negative()) return a.negative() ? -1 : 1;
+    for (size_t i = limbs; i-- > 0; ) {
+        if (a.array[i] != b.array[i]) return (a.array[i] < b.array[i]) ? -1 : 1;
+    }
+    return 0;
+}
+
+template<size_t Bits, bool Signed> constexpr void fixed_bigint<Bits, Signed>::divide(const fixed_bigint& u, const fixed_bigint& v, fixed_bigint* q, fixed_bigint* r) {
+    // Knuth's algorithm D on the unsigned limbs of u and v.
+    size_t n = limbs;
+    while (n && !v.array[n - 1]) --n;
+    if (!n) throw std::invalid_argument("Divide by zero error.");
+    size_t m = limbs;
+    while (m && !u.array[m - 1]) --m;
+
+    fixed_bigint quot;
+    if (n == 1) {
+        limb rem = 0;
+        for (size_t i = m; i-- > 0; ) {
+            const dlimb t = (static_cast<dlimb>(rem) << 64) | u.array[i];
+            quot.array[i] = static_cast<limb>(t / v.array[0]);
+            rem = static_cast<limb>(t % v.array[0]);
+        }
+        if (q) *q = quot;
+        if (r) *r = fixed_bigint(rem);
+        return;
+    }
+    if (m < n) {
+        if (q) *q = quot;
+        if (r) *r = u;
+        return;
+    }
+
+    const unsigned int s = __builtin_clzll(v.array[n - 1]);
+    limb vn[limbs] = {};
+    limb un[limbs + 1] = {};
+    for (size_t i = n; i-- > 0; ) {
+        vn[i] = (v.array[i] << s) | ((s && i) ? v.array[i - 1] >> (64 - s) : 0);
+    }
+    un[m] = s ? u.array[m - 1] >> (64 - s) : 0;
+    for (size_t i = m; i-- > 0; ) {
+        un[i] = (u.array[i] << s) | ((s && i) ? u.array[i - 1] >> (64 - s) : 0);
+    }
+
+    for (size_t j = m - n + 1; j-- > 0; ) {
+        const dlimb top = (static_cast<dlimb>(un[j + n]) << 64) | un[j + n - 1];
+        dlimb qhat = top / vn[n - 1];
+        dlimb rhat = top % vn[n - 1];
+        while (qhat >> 64 || qhat * vn[n - 2] > ((rhat << 64) | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >> 64) break;
+        }
+
+        limb borrow = 0;
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            const dlimb p = qhat * vn[i] + carry;
+            carry = static_cast<limb>(p >> 64);
+            const dlimb t = static_cast<dlimb>(un[i + j]) - static_cast<limb>(p) - borrow;
+            un[i + j] = static_cast<limb>(t);
+            borrow = static_cast<limb>(t >> 64) & 0x1;
+        }
+        const dlimb t = static_cast<dlimb>(un[j + n]) - carry - borrow;
+        un[j + n] = static_cast<limb>(t);
+        if (static_cast<limb>(t >> 64) & 0x1) {
+            --qhat;
+            limb c = 0;
+            for (size_t i = 0; i < n; i++) {
+                const dlimb sum = static_cast<dlimb>(un[i + j]) + vn[i] + c;
+                un[i + j] = static_cast<limb>(sum);
+                c = static_cast<limb>(sum >> 64);
+            }
+            un[j + n] += c;
+        }
+        quot.array[j] = static_cast<limb>(qhat);
+    }
+
+    if (q) *q = quot;
+    if (r) {
+        fixed_bigint rem;
+        for (size_t i = 0; i < n; i++) {
+            rem.array[i] = (un[i] >> s) | (s ? un[i + 1] << (64 - s) : 0);
+        }
+        *r = rem;
+    }
+}
+
+template<size_t Bits, bool Signed> fixed_bigint<Bits, Signed>::fixed_bigint(const bigint& x) : array{} {
+    const size_t n = x.num_limbs();
+    for (size_t i = 0; i < limbs && i < n; i++) {
+        array[i] = x.array[i];
+    }
+    if (x.is_negative) *this = -*this;
+}
+
+template<size_t Bits, bool Signed> fixed_bigint<Bits, Signed>::operator bigint() const {
+    const fixed_bigint m = magnitude();
+    bigint result = bigint::from_limbs(m.array, limbs);
+    result.is_negative = negative();
+    return result;
+}
 
-template<typename T> bool operator+(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) + rhs;}
-template<typename T> bool operator-(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) - rhs;}
-template<typename T> bool operator*(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) * rhs;}
-template<typename T> bool operator/(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) / rhs;}
-template<typename T> bool operator%(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) % rhs;}
+// Integer literals with the _bi suffix, in decimal, octal or with a 0x or 0b
+// prefix, and with optional digit separators. The digits are parsed at compile
+// time into a fixed_bigint, so a literal only copies its limbs at run time.
+//
+// bigint itself is out of scope for constexpr, even where C++20 allows
+// allocation in constant expressions (__cpp_constexpr_dynamic_alloc): its
+// storage comes from memory resources through virtual calls, and its
+// arithmetic is compiled in bigint.cpp. For values needed in constant
+// expressions, use fixed_bigint directly.
+inline namespace bigint_literals {
+    template<char... Digits> bigint operator""_bi() {
+        static constexpr auto value = [] {
+            constexpr char digits[] = {Digits...};
+            constexpr size_t n = sizeof...(Digits);
+            size_t i = 0;
+            unsigned int base = 10;
+            if (n > 1 && digits[0] == '0') {
+                if (digits[1] == 'x' || digits[1] == 'X') {
+                    base = 16;
+                    i = 2;
+                } else if (digits[1] == 'b' || digits[1] == 'B') {
+                    base = 2;
+                    i = 2;
+                } else {
+                    base = 8;
+                    i = 1;
+                }
+            }
 
-template<typename T> bool operator&(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) & rhs;}
-template<typename T> bool operator|(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) | rhs;}
-template<typename T> bool operator^(T lhs, const bigint& rhs) {return static_cast<bigint>(lhs) ^ rhs;}
+            // No base packs more than 4 bits into a digit. Digits are gathered
+            // into a limb before each multiplication, with the single-limb scale
+            // on the left so that the product skips its empty limbs.
+            using value_type = fixed_uint<(4 * n / 64 + 1) * 64>;
+            value_type result;
+            uint64_t chunk = 0;
+            uint64_t scale = 1;
+            for (; i < n; i++) {
+                const char c = digits[i];
+                if (c == '\'') continue;
+                unsigned int d = base;
+                if (c >= '0' && c <= '9') d = c - '0';
+                else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+                if (d >= base) throw std::invalid_argument("Invalid digit in bigint literal.");
+                if (scale > std::numeric_limits<uint64_t>::max() / 16) {
+                    result = value_type(scale) * result + chunk;
+                    chunk = 0;
+                    scale = 1;
+                }
+                chunk = chunk * base + d;
+                scale *= base;
+            }
+            return value_type(scale) * result + chunk;
+        }();
+        return static_cast<bigint>(value);
+    }
+}
 
+// Output follows the stream's width, fill and adjustment, the dec, hex and oct
+// bases with showbase and uppercase, and showpos. Input reads decimal.
 std::ostream& operator<<(std::ostream&, const bigint&);
 std::istream& operator>>(std::istream&, bigint&);
 
 bigint stobi(const std::string&, size_t* = nullptr, int = 10);
+bigint stobi(const char*, size_t, size_t* = nullptr, int = 10);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef BIGINT_TESTS_CHECK_H
+#define BIGINT_TESTS_CHECK_H
+
+#include "bigint.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// A failed CHECK reports the expression and line and marks the test failed,
+// but the test keeps running so one run shows every failure.
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(...) do { \
+    if (!(__VA_ARGS__)) { \
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #__VA_ARGS__); \
+        check_failures()++; \
+    } \
+} while (0)
+
+#define CHECK_THROWS(expr, type) do { \
+    bool thrown_ = false; \
+    try {(void)(expr);} catch (const type&) {thrown_ = true;} \
+    if (!thrown_) { \
+        std::fprintf(stderr, "%s:%d: %s did not throw %s\n", __FILE__, __LINE__, #expr, #type); \
+        check_failures()++; \
+    } \
+} while (0)
+
+inline int check_result(const char* name) {
+    if (check_failures()) {
+        std::fprintf(stderr, "%s: %d checks failed\n", name, check_failures());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// splitmix64, so every run draws the same operands.
+class test_random {
+    private:
+        uint64_t state;
+    public:
+        explicit test_random(uint64_t seed) : state(seed) {}
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+        uint64_t below(uint64_t n) {return next() % n;}
+
+        // A number of exactly the given bit length, sometimes with long runs of
+        // set or clear bits to reach the carry and borrow paths.
+        bigint bits(size_t count, bool allow_negative = false) {
+            if (!count) return bigint();
+            const size_t n = (count + 63) / 64;
+            const int pattern = static_cast<int>(below(4));
+            bigint result;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t word = next();
+                if (pattern == 1) word = ~uint64_t(0);
+                else if (pattern == 2 && i % 3 == 0) word = 0;
+                result = (result << 64) + bigint(word);
+            }
+            result >>= n * 64 - count;
+            result |= bigint(1) << (count - 1);
+            if (allow_negative && (next() & 1)) result = -result;
+            return result;
+        }
+        bigint limbs(size_t count, bool allow_negative = false) {return bits(count * 64 - below(64), allow_negative);}
+};
+
+// Passes allocations on to new_delete_resource, counting them and their bytes.
+class counting_resource : public std::pmr::memory_resource {
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            allocations++;
+            allocated += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {return this == &other;}
+    public:
+        size_t allocations = 0;
+        size_t allocated = 0;
+};
+
+// Sets bigint::tuning for its lifetime. basecase pushes every threshold out of
+// reach, so results computed under it are the reference the fast algorithms
+// are checked against; low brings each algorithm in at a handful of limbs.
+class tuning_scope {
+    private:
+        bigint::tuning_parameters saved;
+    public:
+        explicit tuning_scope(const bigint::tuning_parameters& params) : saved(bigint::tuning) {bigint::tuning = params;}
+        tuning_scope(const tuning_scope&) = delete;
+        tuning_scope& operator=(const tuning_scope&) = delete;
+        ~tuning_scope() {bigint::tuning = saved;}
+
+        static bigint::tuning_parameters basecase() {
+            const size_t never = SIZE_MAX / 4;
+            return {never, never, never, never, never, 1, never, never};
+        }
+        static bigint::tuning_parameters low() {
+            return {4, 8, 12, 16, 2, 1, SIZE_MAX / 4, 4};
+        }
+};
+
+#endif
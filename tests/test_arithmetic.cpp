@@ -0,0 +1,139 @@
+#include "check.h"
+
+#include <string>
+#include <utility>
+
+// The basic operators against __int128 on operands that fit, and against
+// identities that tie them to one another on operands that don't.
+static bigint from_int128(__int128 x) {
+    const bool negative = x < 0;
+    const unsigned __int128 m = negative ? -static_cast<unsigned __int128>(x) : x;
+    const bigint r = (bigint(static_cast<uint64_t>(m >> 64)) << 64) + bigint(static_cast<uint64_t>(m));
+    return negative ? -r : r;
+}
+
+int main() {
+    test_random rng(11);
+    tuning_scope scope(tuning_scope::low());
+
+    for (int i = 0; i < 2000; i++) {
+        const __int128 a = static_cast<__int128>(static_cast<int64_t>(rng.next())) * (__int128(1) << rng.below(50));
+        const __int128 b = static_cast<__int128>(static_cast<int64_t>(rng.next())) >> rng.below(64);
+        const int k = static_cast<int>(rng.below(2000)) - 1000;
+        const bigint x = from_int128(a), y = from_int128(b);
+        CHECK(x + y == from_int128(a + b));
+        CHECK(x - y == from_int128(a - b));
+        CHECK(x + k == from_int128(a + k) && k - x == from_int128(k - a));
+        CHECK(x * k == from_int128(a * k));
+        if (b) {
+            CHECK(x / y == from_int128(a / b));
+            CHECK(x % y == from_int128(a % b));
+        }
+        CHECK((x < y) == (a < b) && (x <= y) == (a <= b) && (x == y) == (a == b));
+        CHECK(x.compare(y) == (a < b ? -1 : a > b));
+        if (a >= 0 && b >= 0) {
+            CHECK((x & y) == from_int128(a & b));
+            CHECK((x | y) == from_int128(a | b));
+            CHECK((x ^ y) == from_int128(a ^ b));
+            const size_t s = rng.below(14);
+            CHECK(x >> s == from_int128(a >> s));
+            CHECK(x << s == from_int128(a << s));
+        }
+    }
+
+    for (int i = 0; i < 200; i++) {
+        const bigint a = rng.limbs(1 + rng.below(40), true);
+        const bigint b = rng.limbs(1 + rng.below(40), true);
+        CHECK(a + b - b == a);
+        CHECK(a - b == -(b - a));
+        CHECK((a + b > a) == (b > 0));
+        CHECK((a + b).compare(a) == b.compare(0));
+        CHECK(a.compare(b) == (a - b).compare(0));
+        CHECK(a.compare_abs(b) == (a < 0 ? -a : a).compare(b < 0 ? -b : b));
+
+        // Compound assignment in place, including onto itself.
+        bigint c = a;
+        c += b;
+        CHECK(c == a + b);
+        c -= a;
+        CHECK(c == b);
+        c *= a;
+        CHECK(c == a * b);
+        c += c;
+        CHECK(c == a * b * 2);
+        c -= c;
+        CHECK(c == 0);
+
+        const bigint ua = a < 0 ? -a : a, ub = b < 0 ? -b : b;
+        CHECK((ua ^ ub) == (ua | ub) - (ua & ub));
+        CHECK((ua & ub) + (ua | ub) == ua + ub);
+
+        // Shifts against multiplication and division by powers of two, in
+        // place and not, whole limbs and not.
+        const size_t s = rng.below(3) ? rng.below(200) : 64 * rng.below(4);
+        const bigint p = bigint::pow(2, s);
+        CHECK((a << s) == a * p);
+        CHECK((a >> s) == a / p);
+        bigint d = a;
+        d <<= s;
+        CHECK(d == a * p);
+        d >>= s;
+        CHECK(d == a);
+        d >>= 64 * 50;
+        CHECK(d == 0 && !(d < 0));
+    }
+
+    // Bitwise operations and hex and binary output on values shifted down in
+    // place, whose limbs above the count are spare, against tight copies.
+    for (int i = 0; i < 50; i++) {
+        bigint a = rng.limbs(60), b = rng.limbs(60);
+        a >>= 64 * rng.below(60);
+        b >>= 64 * rng.below(60);
+        const bigint ta = a, tb = b;
+        CHECK((a & b) == (ta & tb) && (a | b) == (ta | tb) && (a ^ b) == (ta ^ tb));
+        CHECK(a.to_hex() == ta.to_hex() && b.to_bin() == tb.to_bin());
+        bigint c = a;
+        c &= b;
+        CHECK(c == (ta & tb));
+        c = a;
+        c |= b;
+        CHECK(c == (ta | tb));
+        c = a;
+        c ^= b;
+        CHECK(c == (ta ^ tb));
+        c = b;
+        c ^= b;
+        CHECK(c == 0 && c.to_hex() == "0x0");
+    }
+
+    // Values crossing the two inline limbs, growing onto the heap and
+    // shrinking back, then copied and moved out of either storage.
+    for (size_t s : {63, 64, 65, 127, 128, 129, 200}) {
+        const bigint p = bigint(1) << s;
+        bigint x = p;
+        x += p;
+        CHECK(x == bigint(1) << (s + 1));
+        x -= p;
+        x -= p;
+        CHECK(x == bigint() && !(x < bigint()));
+        bigint y = p * p;
+        y /= p;
+        CHECK(y == p);
+        bigint z = std::move(y);
+        CHECK(z == p);
+        y = z;
+        CHECK(y == p && y - z == bigint());
+    }
+
+    bigint n = 0;
+    --n;
+    CHECK(n == -1);
+    n++;
+    CHECK(n == 0 && !n && n.to_string() == "0");
+    CHECK(-bigint() == bigint() && !(-bigint() < 0));
+    CHECK(static_cast<long long>(bigint(-5)) == -5);
+    CHECK(static_cast<unsigned long long>((bigint(1) << 64) - 1) == ~0ULL);
+    CHECK_THROWS(static_cast<unsigned long long>(bigint(1) << 64), std::overflow_error);
+
+    return check_result("test_arithmetic");
+}
@@ -0,0 +1,186 @@
+#include "check.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+// Decimal conversion against a digit-at-a-time reference built on single-limb
+// arithmetic, so the subquadratic splits in both directions are checked
+// against the schoolbook results. Decimal conversion switches algorithms at the
+// division thresholds, which the low tuning brings down to a few limbs.
+static std::string reference_decimal(bigint x) {
+    tuning_scope scope(tuning_scope::basecase());
+    const bool negative = x < 0;
+    if (negative) x = -x;
+    std::string digits;
+    do {
+        const bigint d = x % 10;
+        digits.push_back(static_cast<char>('0' + static_cast<int>(d)));
+        x /= 10;
+    } while (x);
+    if (negative) digits.push_back('-');
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+static std::string random_digits(test_random& rng, size_t n) {
+    std::string s(n, '0');
+    for (char& c : s) c = static_cast<char>('0' + rng.below(10));
+    s[0] = static_cast<char>('1' + rng.below(9));
+    return s;
+}
+
+static bigint reference_parse(const std::string& s) {
+    tuning_scope scope(tuning_scope::basecase());
+    bigint x;
+    for (char c : s) x = x * 10 + (c - '0');
+    return x;
+}
+
+int main() {
+    test_random rng(5);
+    tuning_scope scope(tuning_scope::low());
+
+    for (size_t bits : {1, 63, 64, 65, 300, 1000, 5000, 20000}) {
+        for (int i = 0; i < 3; i++) {
+            const bigint x = rng.bits(bits, true);
+            const std::string s = reference_decimal(x);
+            CHECK(x.to_string() == s);
+            CHECK(stobi(s) == x);
+
+            std::ostringstream os;
+            os << x;
+            CHECK(os.str() == s);
+            std::string written;
+            x.write_decimal([&](const char* p, size_t n) {written.append(p, n);});
+            CHECK(written == s);
+
+            std::istringstream is(s + " rest");
+            bigint y;
+            is >> y;
+            CHECK(is && y == x);
+            std::string rest;
+            is >> rest;
+            CHECK(rest == "rest");
+
+            // Hex and binary, with the same value read back.
+            CHECK(stobi(x.to_hex(), nullptr, 0) == x);
+            const bool negative = x < 0;
+            const std::string bin = x.to_bin().substr(negative ? 1 : 0);
+            bigint fromBin = stobi(bin, nullptr, 2);
+            CHECK((negative ? -fromBin : fromBin) == x);
+        }
+    }
+    // operator<< follows the stream's flags as the built-in integers do.
+    const auto format = [](const auto& x, std::ios_base::fmtflags flags, int width) {
+        std::ostringstream os;
+        os.flags(flags);
+        os.width(width);
+        os.fill('*');
+        os << x;
+        return os.str();
+    };
+    for (long long v : {0LL, 1LL, 7LL, 8LL, 255LL, 123456789LL, 0x7fffffffffffffffLL, -1LL, -4096LL}) {
+        for (std::ios_base::fmtflags base : {std::ios_base::dec, std::ios_base::hex, std::ios_base::oct}) {
+            // Negative values only compare in decimal, as the built-ins print
+            // their two's complement in the other bases.
+            if (v < 0 && base != std::ios_base::dec) continue;
+            for (std::ios_base::fmtflags extra : {std::ios_base::fmtflags(), std::ios_base::showpos,
+                                                  std::ios_base::showbase | std::ios_base::uppercase}) {
+                for (std::ios_base::fmtflags adjust : {std::ios_base::right, std::ios_base::left, std::ios_base::internal}) {
+                    for (int width : {0, 30}) {
+                        const std::ios_base::fmtflags flags = base | extra | adjust;
+                        CHECK(format(bigint(v), flags, width) == format(v, flags, width));
+                    }
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 5; i++) {
+        const bigint x = rng.bits(1 + rng.below(3000));
+        CHECK("0x" + format(x, std::ios_base::hex, 0) == x.to_hex());
+        CHECK(stobi(format(x, std::ios_base::oct | std::ios_base::showbase, 0), nullptr, 0) == x);
+        CHECK(format(-x, std::ios_base::hex | std::ios_base::showbase, 0) == x.to_hex().insert(0, "-"));
+    }
+
+    CHECK(bigint().to_string() == "0");
+    CHECK(bigint().to_hex() == "0x0");
+    CHECK(bigint(-255).to_hex() == "-0xff");
+
+    // Other bases and partial input.
+    size_t pos = 0;
+    CHECK(stobi("  -zz!", &pos, 36) == -(35 * 36 + 35) && pos == 5);
+    CHECK(stobi("0777", nullptr, 0) == 511);
+    CHECK(stobi("0x1F", nullptr, 0) == 31);
+    CHECK(stobi("123", nullptr, 0) == 123);
+    CHECK_THROWS(stobi("x"), std::invalid_argument);
+
+    // The streaming parser, fed in pieces that straddle its chunks, against
+    // the digit-at-a-time reference.
+    for (size_t n : {1, 100, 16383, 16384, 16385, 50000, 140000}) {
+        const std::string s = random_digits(rng, n);
+        const bigint expected = reference_parse(s);
+        CHECK(stobi(s) == expected);
+
+        bigint_parser parser;
+        parser.feed("-", 1);
+        size_t i = 0;
+        while (i < s.size()) {
+            const size_t len = std::min<size_t>(s.size() - i, 1 + rng.below(9000));
+            parser.feed(s.data() + i, len);
+            i += len;
+        }
+        CHECK(parser.finish() == -expected);
+
+        std::istringstream is(s);
+        bigint y;
+        is >> y;
+        CHECK(y == expected);
+    }
+    // Enough chunks for the parser to square up the powers it does not keep,
+    // against the divide-and-conquer conversion of stobi.
+    for (size_t n : {16384 * 32 + 5, 16384 * 47}) {
+        const std::string s = random_digits(rng, n);
+        bigint_parser parser;
+        for (size_t i = 0; i < s.size(); i += 10000) {
+            parser.feed(s.data() + i, std::min<size_t>(s.size() - i, 10000));
+        }
+        CHECK(parser.finish() == stobi(s));
+    }
+
+    // A sign with no digits after it fails without being consumed.
+    for (const char* text : {"-x", "+", "- 1"}) {
+        std::istringstream is(text);
+        bigint y = 5;
+        is >> y;
+        CHECK(is.fail() && y == 5);
+        is.clear();
+        std::string rest;
+        std::getline(is, rest);
+        CHECK(rest == text);
+    }
+
+    bigint_parser parser;
+    CHECK_THROWS(parser.finish(), std::invalid_argument);
+    CHECK_THROWS(parser.feed("1a", 2), std::invalid_argument);
+
+    // Binary import and export in every word order, round-tripping the value.
+    for (size_t bits : {1, 64, 100, 1000}) {
+        const bigint x = rng.bits(bits);
+        for (size_t word : {1, 2, 3, 8, 16}) {
+            for (bigint::endian order : {bigint::endian::little, bigint::endian::big}) {
+                for (bigint::endian bytes : {bigint::endian::little, bigint::endian::big}) {
+                    const size_t count = x.export_size(word);
+                    CHECK(count * word * 8 >= bits && (count - 1) * word * 8 < bits);
+                    std::string buffer(count * word, '\0');
+                    CHECK(x.export_bytes(&buffer[0], count, word, order, bytes) == count);
+                    CHECK(bigint::import_bytes(buffer.data(), count, word, order, bytes) == x);
+                }
+            }
+        }
+    }
+    const bigint big = bigint(1) << 100;
+    unsigned char small[8];
+    CHECK_THROWS(big.export_bytes(small, 1, 8), std::length_error);
+
+    return check_result("test_conversion");
+}
@@ -0,0 +1,72 @@
+#include "check.h"
+
+#include <utility>
+
+// Division against the schoolbook quotient, and every result against the
+// identity a = q * b + r with |r| < |b|. Newton division comes in at two limbs
+// under the low tuning.
+static bigint magnitude(const bigint& x) {
+    return x < 0 ? -x : x;
+}
+
+static void check_division(const bigint& a, const bigint& b) {
+    std::pair<bigint, bigint> expected;
+    {
+        tuning_scope scope(tuning_scope::basecase());
+        expected = bigint::divmod(a, b);
+    }
+    const bigint q = a / b, r = a % b;
+    CHECK(q == expected.first);
+    CHECK(r == expected.second);
+    CHECK(q * b + r == a);
+    CHECK(magnitude(r) < magnitude(b));
+    CHECK(!r || (r < 0) == (a < 0));
+
+    const std::pair<bigint, bigint> floor = bigint::divmod(a, b, bigint::rounding::floor);
+    CHECK(floor.first * b + floor.second == a);
+    CHECK(magnitude(floor.second) < magnitude(b));
+    CHECK(!floor.second || (floor.second < 0) == (b < 0));
+
+    bigint x = a;
+    x /= b;
+    CHECK(x == q);
+    x = a;
+    x %= b;
+    CHECK(x == r);
+}
+
+int main() {
+    test_random rng(2);
+    tuning_scope scope(tuning_scope::low());
+
+    const bigint one = 1;
+    const size_t sizes[] = {1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144};
+    for (size_t an : sizes) {
+        for (size_t bn : sizes) {
+            const bigint a = rng.limbs(an, true);
+            const bigint b = rng.limbs(bn, true);
+            check_division(a, b);
+            check_division(a * b, b);
+            check_division(a * b + one, b);
+            check_division(a * b - one, b);
+        }
+    }
+
+    // Divisors of the form 2^k - 1 and 2^k, whose quotient digits are hardest
+    // to estimate.
+    for (size_t k : {64, 65, 127, 128, 640, 1000}) {
+        const bigint a = rng.bits(3 * k);
+        check_division(a, (one << k) - one);
+        check_division(a, one << k);
+        check_division((one << (2 * k)) - one, (one << k) - one);
+    }
+
+    for (int sign = 0; sign < 4; sign++) {
+        const bigint a = (sign & 1) ? -7 : 7;
+        const bigint b = (sign & 2) ? -2 : 2;
+        check_division(a, b);
+    }
+    CHECK_THROWS(one / bigint(), std::invalid_argument);
+
+    return check_result("test_divide");
+}
@@ -0,0 +1,52 @@
+#include "check.h"
+
+#include <vector>
+
+// factorial, double_factorial and binomial against running products and
+// Pascal's rule, on both sides of the cut between the falling-factorial and
+// the sieved binomial.
+int main() {
+    tuning_scope scope(tuning_scope::low());
+
+    bigint f = 1;
+    bigint df[2] = {1, 1};
+    for (int n = 0; n <= 1200; n++) {
+        if (n) f *= n;
+        if (n > 1) df[n % 2] *= n;
+        if (n < 64 || n % 97 == 0) {
+            CHECK(bigint::factorial(n) == f);
+            CHECK(bigint::double_factorial(n) == df[n % 2]);
+        }
+    }
+
+    std::vector<bigint> row = {1};
+    for (int n = 1; n <= 400; n++) {
+        std::vector<bigint> next(n + 1);
+        next[0] = next[n] = 1;
+        for (int k = 1; k < n; k++) {
+            next[k] = row[k - 1] + row[k];
+        }
+        row.swap(next);
+        if (n < 40 || n % 61 == 0 || n == 400) {
+            for (int k = 0; k <= n; k++) {
+                CHECK(bigint::binomial(n, k) == row[k]);
+            }
+            CHECK(bigint::binomial(n, n + 1) == 0);
+            CHECK(bigint::binomial(n, -1) == 0);
+        }
+    }
+
+    // C(-n, k) = (-1)^k C(n + k - 1, k).
+    for (int n = 1; n < 30; n++) {
+        for (int k = 0; k < 30; k++) {
+            const bigint expected = bigint::binomial(n + k - 1, k);
+            CHECK(bigint::binomial(-n, k) == (k % 2 ? -expected : expected));
+        }
+    }
+
+    CHECK(bigint::binomial(100000, 3) == bigint(100000) * 99999 * 99998 / 6);
+    CHECK_THROWS(bigint::factorial(-1), std::invalid_argument);
+    CHECK_THROWS(bigint::double_factorial(-1), std::invalid_argument);
+
+    return check_result("test_factorial");
+}
@@ -0,0 +1,69 @@
+#include "check.h"
+
+// fixed_bigint against bigint arithmetic reduced modulo 2^Bits, read back as
+// two's complement for the signed types.
+template<size_t Bits, bool Signed> static bigint wrap(const bigint& x) {
+    const bigint modulus = bigint(1) << Bits;
+    bigint r = bigint::divmod(x, modulus, bigint::rounding::floor).second;
+    if (Signed && r >= (modulus >> 1)) r -= modulus;
+    return r;
+}
+
+template<size_t Bits, bool Signed> static void check_width(test_random& rng) {
+    using fixed = fixed_bigint<Bits, Signed>;
+    for (int i = 0; i < 200; i++) {
+        const bigint a = wrap<Bits, Signed>(rng.bits(1 + rng.below(Bits), true));
+        const bigint b = wrap<Bits, Signed>(rng.bits(1 + rng.below(Bits), true));
+        const fixed fa(a), fb(b);
+        CHECK(static_cast<bigint>(fa) == a);
+        CHECK(static_cast<bigint>(fa + fb) == wrap<Bits, Signed>(a + b));
+        CHECK(static_cast<bigint>(fa - fb) == wrap<Bits, Signed>(a - b));
+        CHECK(static_cast<bigint>(fa * fb) == wrap<Bits, Signed>(a * b));
+        CHECK(static_cast<bigint>(-fa) == wrap<Bits, Signed>(-a));
+        if (a >= 0 && b >= 0) {
+            // bigint's bitwise operators act on magnitudes.
+            CHECK(static_cast<bigint>(fa & fb) == wrap<Bits, Signed>(a & b));
+            CHECK(static_cast<bigint>(fa | fb) == wrap<Bits, Signed>(a | b));
+            CHECK(static_cast<bigint>(fa ^ fb) == wrap<Bits, Signed>(a ^ b));
+        }
+        if (b) {
+            CHECK(static_cast<bigint>(fa / fb) == wrap<Bits, Signed>(a / b));
+            CHECK(static_cast<bigint>(fa % fb) == wrap<Bits, Signed>(a % b));
+        }
+        CHECK((fa < fb) == (a < b));
+        CHECK((fa == fb) == (a == b));
+
+        const size_t shift = rng.below(Bits + 10);
+        CHECK(static_cast<bigint>(fa << shift) == wrap<Bits, Signed>(a << shift));
+        if (Signed || a >= 0) {
+            // bigint shifts magnitudes, so compare arithmetic shifts by floor division.
+            const bigint expected = bigint::divmod(a, bigint(1) << shift, bigint::rounding::floor).first;
+            CHECK(static_cast<bigint>(fa >> shift) == wrap<Bits, Signed>(expected));
+        }
+    }
+}
+
+int main() {
+    test_random rng(7);
+    check_width<64, false>(rng);
+    check_width<64, true>(rng);
+    check_width<128, false>(rng);
+    check_width<128, true>(rng);
+    check_width<256, true>(rng);
+    check_width<512, false>(rng);
+
+    // Constant evaluation.
+    constexpr fixed_uint<128> x = fixed_uint<128>(~uint64_t(0)) * fixed_uint<128>(~uint64_t(0));
+    static_assert(static_cast<uint64_t>(x) == 1, "low limb of (2^64 - 1)^2");
+    static_assert(fixed_int<128>(-1) < fixed_int<128>(0), "signed comparison");
+    static_assert(fixed_uint<256>(7) / fixed_uint<256>(2) == fixed_uint<256>(3), "constexpr division");
+
+    // The literal, parsed at compile time into a bigint.
+    using namespace bigint_literals;
+    CHECK(123456789012345678901234567890_bi == stobi("123456789012345678901234567890"));
+    CHECK(0xffffffffffffffffffffffff_bi == (bigint(1) << 96) - 1);
+    CHECK(0b1010_bi == 10 && 0777_bi == 511 && 0_bi == 0);
+    CHECK(1'000'000'000'000'000'000'000_bi == bigint::pow(10, 21));
+
+    return check_result("test_fixed");
+}
@@ -0,0 +1,94 @@
+#include "check.h"
+
+#include <tuple>
+
+// gcd against Euclid's algorithm on the schoolbook remainder; gcdext and
+// invert against the identities that define them. The half-gcd comes in at
+// four limbs under the low tuning.
+static bigint euclid(bigint a, bigint b) {
+    tuning_scope scope(tuning_scope::basecase());
+    if (a < 0) a = -a;
+    if (b < 0) b = -b;
+    while (b) {
+        bigint r = a % b;
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
+
+static void check_gcd(const bigint& a, const bigint& b) {
+    const bigint g = euclid(a, b);
+    CHECK(bigint::gcd(a, b) == g);
+    CHECK(bigint::gcd(b, a) == g);
+
+    bigint eg, s, t;
+    std::tie(eg, s, t) = bigint::gcdext(a, b);
+    CHECK(eg == g);
+    CHECK(a * s + b * t == g);
+
+    if (g == 1 && b != 0) {
+        const bigint m = b < 0 ? -b : b;
+        const bigint inv = bigint::invert(a, b);
+        CHECK(inv >= 0 && inv < m);
+        CHECK(bigint::divmod(a * inv, m, bigint::rounding::floor).second == (m == 1 ? 0 : 1));
+    }
+}
+
+int main() {
+    test_random rng(3);
+    tuning_scope scope(tuning_scope::low());
+
+    for (size_t bits : {1, 30, 64, 65, 200, 500, 1000, 3000, 10000, 30000}) {
+        for (int i = 0; i < 4; i++) {
+            const bigint a = rng.bits(bits, true);
+            const bigint b = rng.bits(bits - rng.below(bits / 2 + 1), true);
+            check_gcd(a, b);
+
+            // A large common factor.
+            const bigint f = rng.bits(bits / 2 + 1);
+            check_gcd(a * f, b * f);
+        }
+    }
+
+    // Consecutive Fibonacci numbers take the most steps.
+    bigint f0 = 0, f1 = 1;
+    for (int i = 0; i < 5000; i++) {
+        f0 += f1;
+        std::swap(f0, f1);
+    }
+    check_gcd(f1, f0);
+
+    // Operands that differ by a small amount, whose first quotient is 1 and
+    // whose difference is far below half their length. The half-gcd once
+    // recursed on such inputs without shrinking them.
+    for (size_t limbs : {3, 5, 40, 300, 700}) {
+        const bigint b = rng.limbs(limbs, true);
+        for (const bigint& delta : {bigint(1), bigint(-12345), rng.bits(100), rng.bits(64 * limbs / 3)}) {
+            check_gcd(b, b + delta);
+            check_gcd(b + delta, b);
+            check_gcd(b * delta, (b + 1) * delta);
+            const bigint m = (b < 0 ? -b : b) | 1;
+            CHECK(bigint::powmod(m - 2, -1, m) == bigint::invert(m - 2, m));
+        }
+    }
+    check_gcd(stobi("-0x3232e7ea2e87915d", nullptr, 0), (bigint(1) << 300) - 12345);
+    {
+        // And at the default thresholds, above and below the half-gcd's.
+        tuning_scope defaults({BIGINT_KARATSUBA_THRESHOLD, BIGINT_TOOM3_THRESHOLD, BIGINT_TOOM4_THRESHOLD,
+                               BIGINT_FFT_THRESHOLD, BIGINT_NEWTON_THRESHOLD, 1, BIGINT_PARALLEL_THRESHOLD,
+                               BIGINT_HGCD_THRESHOLD});
+        for (size_t limbs : {BIGINT_HGCD_THRESHOLD / 2, BIGINT_HGCD_THRESHOLD * 5 / 2}) {
+            const bigint m = rng.limbs(limbs) | 1;
+            check_gcd(m - 12345, m);
+            check_gcd(m, m + 2);
+        }
+    }
+
+    check_gcd(0, 0);
+    check_gcd(rng.bits(300, true), 0);
+    check_gcd(0, rng.bits(300, true));
+    CHECK_THROWS(bigint::invert(6, 9), std::invalid_argument);
+
+    return check_result("test_gcd");
+}
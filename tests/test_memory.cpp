@@ -0,0 +1,113 @@
+#include "check.h"
+
+#include <cstring>
+
+// The memory resources: numbers built on each compute the same values as on
+// the default heap, and follow the std::pmr rules for which resource a copy or
+// move uses.
+
+static bigint workload(test_random& rng) {
+    bigint acc = 1;
+    for (int i = 0; i < 20; i++) {
+        const bigint x = rng.limbs(1 + rng.below(300), true);
+        acc = acc * x + (x >> 17);
+        acc %= rng.limbs(400);
+    }
+    return acc;
+}
+
+static void check_resource(std::pmr::memory_resource* mr) {
+    test_random expected_rng(9), rng(9);
+    const bigint expected = workload(expected_rng);
+
+    bigint::set_default_resource(mr);
+    CHECK(bigint::default_resource() == mr);
+    const bigint result = workload(rng);
+    CHECK(result.get_resource() == mr);
+    bigint::set_default_resource(nullptr);
+
+    CHECK(result == expected);
+    CHECK(bigint::default_resource() == std::pmr::get_default_resource());
+}
+
+int main() {
+    tuning_scope scope(tuning_scope::low());
+
+    {
+        bigint_arena arena(1024);
+        check_resource(&arena);
+        CHECK(arena.bytes_allocated() > 0);
+        arena.release();
+        CHECK(arena.bytes_allocated() == 0);
+    }
+    {
+        bigint_pool pool;
+        check_resource(&pool);
+    }
+    {
+        // A low threshold sends most numbers and the multiplication scratch
+        // buffers to mapped files.
+        bigint_mmap_resource mapped("", 4096);
+        check_resource(&mapped);
+
+        // Growing and shrinking a mapped block keeps its contents.
+        char* p = static_cast<char*>(mapped.allocate(1 << 16));
+        std::memset(p, 7, 1 << 16);
+        p = static_cast<char*>(mapped.reallocate(p, 1 << 16, 1 << 20));
+        CHECK(p && p[0] == 7 && p[(1 << 16) - 1] == 7 && p[1 << 16] == 0);
+        p = static_cast<char*>(mapped.reallocate(p, 1 << 20, 1 << 13));
+        CHECK(p && p[(1 << 13) - 1] == 7);
+        mapped.deallocate(p, 1 << 13);
+        CHECK(mapped.reallocate(nullptr, 16, 1 << 20) == nullptr);
+
+        // A number given the resource explicitly, rather than through the
+        // default, also grows and shrinks in place.
+        test_random rng(12);
+        const bigint x = rng.limbs(1000, true);
+        bigint y(&mapped);
+        y = x;
+        y <<= 64 * 5000 + 3;
+        CHECK(y.get_resource() == &mapped && y == x * bigint::pow(2, 64 * 5000 + 3));
+        y >>= 64 * 5000 + 3;
+        CHECK(y == x);
+    }
+
+    // Copies take the default resource, moves keep the source's, and
+    // assignment keeps the destination's.
+    bigint_pool pool;
+    test_random rng(10);
+    const bigint x(rng.limbs(10), &pool);
+    CHECK(x.get_resource() == &pool);
+    const bigint copy = x;
+    CHECK(copy.get_resource() == bigint::default_resource() && copy == x);
+    bigint moved = bigint(x, &pool);
+    const bigint target = std::move(moved);
+    CHECK(target.get_resource() == &pool && target == x);
+    bigint assigned;
+    assigned = x;
+    CHECK(assigned.get_resource() == bigint::default_resource() && assigned == x);
+
+    // A copy takes only the limbs in use, not the source's spare capacity, and
+    // assigning a shorter value clears the rest of the destination's limbs.
+    {
+        bigint big = rng.limbs(1000);
+        big >>= 64 * 990;
+        counting_resource counter;
+        bigint::set_default_resource(&counter);
+        const bigint small = big;
+        bigint::set_default_resource(nullptr);
+        CHECK(small == big);
+        CHECK(counter.allocated <= 10 * sizeof(uint64_t));
+
+        bigint dest = rng.limbs(1000);
+        dest = small;
+        CHECK(dest == small);
+        dest <<= 64 * 500;
+        CHECK(dest == small * bigint::pow(2, 64 * 500));
+        dest = bigint(3);
+        dest += bigint(1) << (64 * 20);
+        CHECK(dest == (bigint(1) << (64 * 20)) + 3);
+    }
+
+    return check_result("test_memory");
+}
@@ -0,0 +1,85 @@
+#include "check.h"
+
+// powmod and the residue arithmetic of bigint_mod_context against plain
+// multiplication followed by %, for odd moduli (Montgomery) and even ones
+// (Barrett).
+static bigint reduce(const bigint& x, const bigint& m) {
+    return bigint::divmod(x, m, bigint::rounding::floor).second;
+}
+
+static bigint reference_powmod(bigint base, bigint exp, const bigint& m) {
+    tuning_scope scope(tuning_scope::basecase());
+    bigint result = reduce(1, m);
+    base = reduce(base, m);
+    while (exp) {
+        if ((exp & 1) != 0) result = reduce(result * base, m);
+        base = reduce(base * base, m);
+        exp >>= 1;
+    }
+    return result;
+}
+
+int main() {
+    test_random rng(6);
+    tuning_scope scope(tuning_scope::low());
+
+    for (size_t bits : {2, 64, 65, 130, 500, 1500}) {
+        for (int parity = 0; parity < 2; parity++) {
+            bigint m = rng.bits(bits);
+            if ((m & 1) != parity) m += 1;
+            if (m.to_bin().size() > bits) m -= 2;
+            const bigint_mod_context ctx(m);
+            CHECK(ctx.modulus() == m);
+
+            for (int i = 0; i < 3; i++) {
+                const bigint a = rng.bits(1 + rng.below(2 * bits), true);
+                const bigint b = rng.bits(1 + rng.below(2 * bits), true);
+                const bigint e = rng.bits(1 + rng.below(200));
+                const bigint_mod_context::residue ra = ctx(a), rb = ctx(b);
+                CHECK(ra.value() == reduce(a, m));
+                CHECK((ra + rb).value() == reduce(a + b, m));
+                CHECK((ra - rb).value() == reduce(a - b, m));
+                CHECK((ra * rb).value() == reduce(a * b, m));
+                CHECK((-ra).value() == reduce(-a, m));
+                CHECK((ra * rb == rb * ra));
+                CHECK(ra.pow(e).value() == reference_powmod(a, e, m));
+                CHECK(bigint::powmod(a, e, m) == reference_powmod(a, e, m));
+                CHECK(bigint::powmod(a, e, -m) == reference_powmod(a, e, m));
+
+                // Negative exponents go through the inverse.
+                if (bigint::gcd(a, m) == 1) {
+                    const bigint inv = bigint::invert(a, m);
+                    CHECK(bigint::powmod(a, -e, m) == reference_powmod(inv, e, m));
+                    CHECK(ra.pow(-e).value() == reference_powmod(inv, e, m));
+                }
+            }
+            CHECK(bigint::powmod(rng.bits(bits), 0, m) == reduce(1, m));
+        }
+    }
+
+    // Moves between memory resources copy, and must still leave room for n
+    // limbs.
+    for (int parity = 0; parity < 2; parity++) {
+        const bigint m = (rng.bits(1000) | 1) + parity;
+        const bigint_mod_context ctx(m);
+        const bigint x = rng.bits(900);
+        bigint_pool pool;
+        bigint::set_default_resource(&pool);
+        bigint_mod_context::residue d = ctx(x);
+        bigint_mod_context::residue e = std::move(d);
+        bigint::set_default_resource(nullptr);
+        d = std::move(ctx(0));
+        e *= d;
+        CHECK(e.value() == 0);
+        bigint_mod_context::residue f = std::move(e);
+        CHECK(f == ctx(0));
+    }
+
+    const bigint_mod_context a(101), b(103);
+    CHECK_THROWS(a(1) + b(1), std::invalid_argument);
+    CHECK_THROWS(bigint::powmod(2, 5, 0), std::invalid_argument);
+    CHECK_THROWS(bigint::powmod(6, -1, 9), std::invalid_argument);
+    CHECK_THROWS(a(0).pow(-1), std::invalid_argument);
+
+    return check_result("test_modular");
+}
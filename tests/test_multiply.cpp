@@ -0,0 +1,99 @@
+#include "check.h"
+
+#include <vector>
+
+// Every multiplication algorithm against the schoolbook product: Karatsuba,
+// Toom-3, Toom-4 and the NTT come in at a few limbs under the low tuning, and
+// the parallel split at a few more.
+static bigint reference(const bigint& a, const bigint& b) {
+    tuning_scope scope(tuning_scope::basecase());
+    return a * b;
+}
+
+static void check_product(const bigint& a, const bigint& b) {
+    const bigint expected = reference(a, b);
+    CHECK(a * b == expected);
+    CHECK(b * a == expected);
+    bigint c = a;
+    c *= b;
+    CHECK(c == expected);
+    bigint acc = a;
+    bigint::addmul(acc, a, b);
+    CHECK(acc == a + expected);
+    bigint::submul(acc, a, b);
+    CHECK(acc == a);
+}
+
+int main() {
+    test_random rng(1);
+    tuning_scope scope(tuning_scope::low());
+
+    const std::vector<size_t> sizes = {1, 2, 3, 4, 5, 7, 8, 9, 12, 13, 16, 17, 24, 31, 40, 64, 100, 160};
+    for (size_t an : sizes) {
+        for (size_t bn : sizes) {
+            if (bn > an) continue;
+            const bigint a = rng.limbs(an, true);
+            const bigint b = rng.limbs(bn, true);
+            check_product(a, b);
+        }
+        const bigint a = rng.limbs(an, true);
+        const bigint sq = a * a;
+        CHECK(sq == reference(a, a));
+        CHECK(bigint::mul_fft(a, a) == sq);
+    }
+
+    // Operands of very different lengths, which multiply in pieces.
+    for (int i = 0; i < 10; i++) {
+        const bigint a = rng.limbs(200 + rng.below(200), true);
+        const bigint b = rng.limbs(5 + rng.below(40), true);
+        check_product(a, b);
+        CHECK(bigint::mul_fft(a, b) == reference(a, b));
+    }
+
+    // The parallel paths, with helper threads splitting the top-level products
+    // and transforms.
+    {
+        bigint::tuning_parameters params = tuning_scope::low();
+        params.threads = 3;
+        params.parallel_threshold = 16;
+        tuning_scope threads(params);
+        for (size_t n : {16, 40, 100, 300}) {
+            const bigint a = rng.limbs(n, true);
+            const bigint b = rng.limbs(n - rng.below(n / 2), true);
+            check_product(a, b);
+            CHECK(bigint::mul_fft(a, b) == reference(a, b));
+        }
+    }
+
+    // Multiplication by zero, one and single limbs.
+    const bigint a = rng.limbs(50, true);
+    CHECK(a * bigint() == bigint());
+    CHECK(a * 1 == a);
+    CHECK(a * -1 == -a);
+    CHECK(a * 3 == a + a + a);
+    bigint acc = a;
+    bigint::addmul(acc, a, uint64_t(7));
+    CHECK(acc == a * 8);
+    bigint::submul(acc, a, uint64_t(8));
+    CHECK(acc == bigint());
+
+    // Expression templates evaluate to the same values as the plain operators.
+    const bigint b = rng.limbs(30, true), c = rng.limbs(20, true);
+    bigint e = bigint::lazy(a) * b + c * a - (bigint::lazy(b) << 70);
+    CHECK(e == a * b + c * a - (b << 70));
+    e += bigint::lazy(a) * c;
+    CHECK(e == a * b + c * a - (b << 70) + a * c);
+    bigint f = e;
+    f = bigint::lazy(f) * b + f;
+    CHECK(f == e * b + e);
+
+    // pow against repeated multiplication.
+    bigint power = 1;
+    const bigint base = rng.limbs(3, true);
+    for (int k = 0; k <= 40; k++) {
+        CHECK(bigint::pow(base, k) == power);
+        power *= base;
+    }
+
+    return check_result("test_multiply");
+}
@@ -0,0 +1,49 @@
+#include "check.h"
+
+#include <utility>
+
+// Roots against their defining bounds r^k <= |n| < (r + 1)^k, which pin the
+// result down whichever iteration produced it.
+static void check_root(const bigint& n, uint64_t k) {
+    const std::pair<bigint, bigint> rr = bigint::rootrem(n, k);
+    const bigint& r = rr.first;
+    CHECK(bigint::iroot(n, k) == r);
+    CHECK(rr.second == n - bigint::pow(r, k));
+    const bigint an = n < 0 ? -n : n, ar = r < 0 ? -r : r;
+    CHECK(bigint::pow(ar, k) <= an);
+    CHECK(bigint::pow(ar + 1, k) > an);
+    CHECK(!r || (r < 0) == (n < 0));
+    if (k == 2) {
+        CHECK(bigint::isqrt(n) == r);
+        CHECK(bigint::sqrtrem(n) == rr);
+        CHECK(bigint::is_square(n) == !rr.second);
+    }
+}
+
+int main() {
+    test_random rng(4);
+    tuning_scope scope(tuning_scope::low());
+
+    for (size_t bits : {1, 10, 63, 64, 65, 128, 300, 1000, 4000, 12000}) {
+        for (uint64_t k : {2, 3, 4, 5, 7, 17}) {
+            if (k > bits + 1) continue;
+            const bigint n = rng.bits(bits, k % 2 == 1);
+            check_root(n, k);
+            const bigint r = rng.bits(bits / k + 1, k % 2 == 1);
+            const bigint p = bigint::pow(r, k);
+            check_root(p, k);
+            check_root(p - 1, k);
+            check_root(p + 1, k);
+            CHECK(bigint::is_perfect_power(p));
+        }
+    }
+
+    CHECK(bigint::is_perfect_power(0) && bigint::is_perfect_power(1) && bigint::is_perfect_power(-1));
+    CHECK(!bigint::is_perfect_power(2) && !bigint::is_perfect_power(-4));
+    CHECK(bigint::is_perfect_power(-8));
+    CHECK(!bigint::is_perfect_power(bigint::pow(3, 40) * 2));
+    CHECK_THROWS(bigint::isqrt(-1), std::invalid_argument);
+    CHECK_THROWS(bigint::iroot(5, 0), std::invalid_argument);
+
+    return check_result("test_roots");
+}
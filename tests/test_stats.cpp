@@ -0,0 +1,38 @@
+#include "check.h"
+
+#include <cstring>
+
+// The counters behind bigint::stats(). They only count in a build with
+// BIGINT_STATS (cmake -DBIGINT_STATS=ON); otherwise they stay zero.
+int main() {
+    test_random rng(13);
+    tuning_scope scope(tuning_scope::low());
+    using op = bigint::operation;
+
+    const bigint a = rng.limbs(100), b = rng.limbs(90);
+    bigint::reset_stats();
+    const bigint product = a * b;
+    bigint::statistics s = bigint::stats();
+#if BIGINT_STATS
+    CHECK(s.calls[static_cast<size_t>(op::multiply)] == 1);
+    CHECK(s.allocations[static_cast<size_t>(op::multiply)] >= 1);
+    CHECK(s.multiply_sizes[7] == 1);
+    uint64_t timed = 0;
+    for (uint64_t calls : s.tier_calls) timed += calls;
+    CHECK(timed >= 1);
+
+    // The multiplications inside a power count as the power.
+    bigint::reset_stats();
+    const bigint cube = bigint::pow(product, 3);
+    s = bigint::stats();
+    CHECK(s.calls[static_cast<size_t>(op::power)] == 1);
+    CHECK(s.calls[static_cast<size_t>(op::multiply)] == 0);
+    CHECK(cube == product * product * product);
+#else
+    const bigint::statistics zero = {};
+    CHECK(std::memcmp(&s, &zero, sizeof(s)) == 0);
+    CHECK(product == b * a);
+#endif
+
+    return check_result("test_stats");
+}
@@ -0,0 +1,61 @@
+#include "check.h"
+
+#include <vector>
+
+// bigint_view arithmetic and comparisons over caller-owned limbs against the
+// same operations on bigints.
+int main() {
+    test_random rng(8);
+    tuning_scope scope(tuning_scope::low());
+
+    for (int i = 0; i < 100; i++) {
+        const bigint a = rng.limbs(1 + rng.below(60), true);
+        const bigint b = i % 10 ? rng.limbs(1 + rng.below(60), true) : a;
+
+        std::vector<uint64_t> buffer(a.export_size(8));
+        a.export_bytes(buffer.data(), buffer.size(), 8);
+        const bigint_view va(buffer.data(), buffer.size(), a < 0);
+        const bigint_view vb = b;
+
+        CHECK(bigint(va) == a);
+        CHECK(va.compare(vb) == a.compare(b));
+        CHECK((va == vb) == (a == b));
+        CHECK((va < vb) == (a < b));
+        CHECK((va >= vb) == (a >= b));
+        CHECK(va + vb == a + b);
+        CHECK(va - vb == a - b);
+        CHECK(va * vb == a * b);
+        CHECK(va / vb == a / b);
+        CHECK(va % vb == a % b);
+        CHECK(-va + vb == b - a);
+
+        // Views mix with bigints on either side.
+        CHECK(a + vb == a + b);
+        CHECK(va * b == a * b);
+    }
+
+    // Limbs with leading zeros and an empty view.
+    const uint64_t padded[] = {5, 0, 0};
+    CHECK(bigint_view(padded, 3) == bigint_view(padded, 1));
+    CHECK(bigint(bigint_view(padded, 3)) == 5);
+    CHECK(bigint(bigint_view(padded, 0, true)) == 0);
+    CHECK(bigint_view(padded, 0) == bigint());
+
+    // Comparing a bigint with a view reads both in place rather than copying
+    // the view into a bigint.
+    {
+        const bigint a = rng.limbs(20, true);
+        std::vector<uint64_t> buffer(a.export_size(8));
+        a.export_bytes(buffer.data(), buffer.size(), 8);
+        const bigint_view v(buffer.data(), buffer.size(), a < 0);
+
+        counting_resource counter;
+        bigint::set_default_resource(&counter);
+        const bool equal = a == v && v == a && !(a != v) && !(a < v) && a <= v && v >= a && !(v > a);
+        bigint::set_default_resource(nullptr);
+        CHECK(equal);
+        CHECK(counter.allocations == 0);
+    }
+
+    return check_result("test_view");
+}